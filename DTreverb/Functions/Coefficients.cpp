@@ -0,0 +1,62 @@
+#define _USE_MATH_DEFINES
+#include "Coefficients.h"
+#include "DTMath.h"
+#include <cmath>
+
+//NAN never compares equal, so every group starts uncooked
+CookedCoefficients::CookedCoefficients()
+{
+	fs = 0.0;
+	gain = cutoff = decay = NAN;
+	gainlin = 1.0;
+	cutoffgain = 0.0;
+	for (int i = 0; i < FDN::maxlines; i++) feedback[i] = 0.0;
+}
+
+void CookedCoefficients::setsamplerate(double sampleRate)
+{
+	if (sampleRate == fs) return;
+	fs = sampleRate;
+	cutoff = decay = NAN;  //the gain does not depend on the rate
+}
+
+void CookedCoefficients::cookgain(double a)
+{
+	if (a == gain) return;
+	gain = a;
+	gainlin = dtpow(10, gain / 20);
+}
+
+void CookedCoefficients::cookcutoff(double a)
+{
+	if (a == cutoff) return;
+	cutoff = a;
+	cutoffgain = dtexp(-2 * M_PI * (cutoff / fs));  //same expression as LowpassFilter, StereoDiffuser and EarlyReflections
+}
+
+void CookedCoefficients::cookdecay(double a)
+{
+	if (a == decay) return;
+	decay = a;
+	FDN::decaycoefficients(fs, decay, feedback);
+}
+
+void CookedCoefficients::take(const CookedCoefficients& other)
+{
+	if (other.gain == other.gain)
+	{
+		gain = other.gain;
+		gainlin = other.gainlin;
+	}
+	if (other.fs != fs) return;
+	if (other.cutoff == other.cutoff)
+	{
+		cutoff = other.cutoff;
+		cutoffgain = other.cutoffgain;
+	}
+	if (other.decay == other.decay)
+	{
+		decay = other.decay;
+		memcpy(feedback, other.feedback, sizeof(feedback));
+	}
+}
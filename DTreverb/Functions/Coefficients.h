@@ -0,0 +1,28 @@
+#ifndef Coefficients_h
+#define Coefficients_h
+#include <stdio.h>
+#include <string.h>
+#include "FDN.h"
+
+//the coefficients that cost an exp or pow to cook, each kept with the value and sample rate it was
+//cooked for. The audio thread keeps one set and only recomputes a group when its value changes; a
+//preset morph cooks whole sets on the GUI thread and hands them over, so the audio thread takes
+//them instead of cooking. Any set is a valid cache, a stale one only misses
+struct CookedCoefficients {
+	CookedCoefficients();
+	void setsamplerate(double sampleRate);   //forgets everything cooked at another rate
+	void cookgain(double a);                 //dB
+	void cookcutoff(double a);               //Hz, one pole gain of the input and early reflection lowpasses
+	void cookdecay(double a);                //decay factor, per line feedback of the FDN
+	void take(const CookedCoefficients& other);  //groups of other that were cooked at this rate
+
+	double fs;
+	double gain;
+	double gainlin;
+	double cutoff;
+	double cutoffgain;
+	double decay;
+	double feedback[FDN::maxlines];
+};
+
+#endif
@@ -0,0 +1,439 @@
+#include "Convolver.h"
+#include "DTMath.h"
+#include <string.h>
+#include <cmath>
+#include <chrono>
+
+UniformConvolver::UniformConvolver()
+{
+	block = bins = partitions = 0;
+	fdlpos = 0;
+}
+
+void UniformConvolver::setup(int _block, int _partitions)
+{
+	block = _block;
+	bins = block + 1;
+	partitions = _partitions > 0 ? _partitions : 1;
+	fft.setsize(2 * block);
+	window.assign(2 * block, 0.0);
+	workre.assign(2 * block, 0.0);
+	workim.assign(2 * block, 0.0);
+	fdlre.assign((size_t)partitions * bins, 0.0);
+	fdlim.assign((size_t)partitions * bins, 0.0);
+	for (int c = 0; c < 2; c++)
+	{
+		accre[c].assign(bins, 0.0);
+		accim[c].assign(bins, 0.0);
+	}
+	fdlpos = 0;
+}
+
+void UniformConvolver::reset()
+{
+	std::fill(window.begin(), window.end(), 0.0);
+	std::fill(fdlre.begin(), fdlre.end(), 0.0);
+	std::fill(fdlim.begin(), fdlim.end(), 0.0);
+	fdlpos = 0;
+}
+
+void UniformConvolver::spectra(const float* ir, int length, double* re, double* im)
+{
+	for (int p = 0; p * block < length; p++)
+	{
+		for (int i = 0; i < 2 * block; i++)
+		{
+			int n = p * block + i;
+			workre[i] = (i < block && n < length) ? ir[n] : 0.0;
+			workim[i] = 0.0;
+		}
+		fft.forward(&workre[0], &workim[0]);
+		memcpy(re + (size_t)p * bins, &workre[0], bins * sizeof(double));
+		memcpy(im + (size_t)p * bins, &workim[0], bins * sizeof(double));
+	}
+}
+
+void UniformConvolver::process(const double* input, const double* const* hre, const double* const* him, int parts, double* outL, double* outR)
+{
+	//overlap-save: transform the last two blocks of input
+	memmove(&window[0], &window[block], block * sizeof(double));
+	memcpy(&window[block], input, block * sizeof(double));
+	memcpy(&workre[0], &window[0], 2 * block * sizeof(double));
+	memset(&workim[0], 0, 2 * block * sizeof(double));
+	fft.forward(&workre[0], &workim[0]);
+
+	fdlpos = fdlpos > 0 ? fdlpos - 1 : partitions - 1;
+	memcpy(&fdlre[(size_t)fdlpos * bins], &workre[0], bins * sizeof(double));
+	memcpy(&fdlim[(size_t)fdlpos * bins], &workim[0], bins * sizeof(double));
+
+	//multiply-accumulate every partition with the input block as old as it is
+	if (parts > partitions) parts = partitions;
+	for (int c = 0; c < 2; c++)
+	{
+		double* ar = &accre[c][0];
+		double* ai = &accim[c][0];
+		memset(ar, 0, bins * sizeof(double));
+		memset(ai, 0, bins * sizeof(double));
+		for (int p = 0; p < parts; p++)
+		{
+			int slot = fdlpos + p < partitions ? fdlpos + p : fdlpos + p - partitions;
+			const double* xr = &fdlre[(size_t)slot * bins];
+			const double* xi = &fdlim[(size_t)slot * bins];
+			const double* hr = hre[c] + (size_t)p * bins;
+			const double* hi = him[c] + (size_t)p * bins;
+			for (int k = 0; k < bins; k++)
+			{
+				ar[k] += xr[k] * hr[k] - xi[k] * hi[k];
+				ai[k] += xr[k] * hi[k] + xi[k] * hr[k];
+			}
+		}
+	}
+
+	//both outputs are real, so one inverse transform of L + iR gives L in the real and R in the imaginary part
+	int n = 2 * block;
+	for (int k = 0; k < bins; k++)
+	{
+		workre[k] = accre[0][k] - accim[1][k];
+		workim[k] = accim[0][k] + accre[1][k];
+	}
+	for (int k = bins; k < n; k++)
+	{
+		int m = n - k;
+		workre[k] = accre[0][m] + accim[1][m];
+		workim[k] = -accim[0][m] + accre[1][m];
+	}
+	fft.inverse(&workre[0], &workim[0]);
+
+	//only the second half is free of circular wrap
+	memcpy(outL, &workre[block], block * sizeof(double));
+	memcpy(outR, &workim[block], block * sizeof(double));
+}
+
+
+ConvolutionReverb::ConvolutionReverb()
+	: pending(nullptr), retired(nullptr), requested(false), submitted(0), completed(0), missed(0), quit(false), running(false), wakeloader(false)
+{
+	fs = 0;
+	B = T = 0;
+	advance = 0;
+	active = nullptr;
+	synchronous = false;
+	enabled = false;
+	sample = 0;
+	headpos = 0;
+	tailmissing = false;
+	wakeworker = false;
+	for (int i = 0; i < slots; i++) jobkernel[i] = nullptr;
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+	std::lock_guard<std::mutex> guard(control);
+	stop();
+	delete active;
+	delete pending.exchange(nullptr);
+	delete retired.exchange(nullptr);
+}
+
+void ConvolutionReverb::Buffersize(double sampleRate, int headblock, int lead)
+{
+	std::lock_guard<std::mutex> guard(control);
+	stop();
+	delete active;
+	active = nullptr;
+	delete pending.exchange(nullptr);
+	delete retired.exchange(nullptr);
+
+	fs = sampleRate;
+	B = headblock;
+	T = tailfactor * B;
+	advance = lead < B ? lead : B;
+
+	//the head covers the first two tail blocks, which is the time the worker gets for each tail block
+	head.setup(B, 2 * T / B);
+	tail.setup(T, (int)(maxseconds * fs) / T + 1);
+
+	headin.assign(B, 0.0);
+	tailin.assign((size_t)slots * T, 0.0);
+	for (int c = 0; c < 2; c++)
+	{
+		headout[c].assign(B, 0.0);
+		tailout[c].assign((size_t)slots * T, 0.0);
+	}
+	for (int i = 0; i < slots; i++) jobkernel[i] = nullptr;
+	sample = 0;
+	headpos = 0;
+	tailmissing = false;
+	wakeworker = false;
+	submitted = 0;
+	completed = 0;
+	missed = 0;
+
+	start();
+}
+
+void ConvolutionReverb::setcapture(Capture f)
+{
+	capture = f;
+}
+
+void ConvolutionReverb::setsynchronous(bool a)
+{
+	std::lock_guard<std::mutex> guard(control);
+	stop();
+	synchronous = a;
+	start();
+}
+
+void ConvolutionReverb::setenabled(bool a)
+{
+	std::lock_guard<std::mutex> guard(control);
+	enabled = a;
+	if (enabled) start();
+	else stop();
+}
+
+void ConvolutionReverb::start()
+{
+	if (!enabled || synchronous || !capture || B == 0 || worker.joinable()) return;
+
+	quit = false;
+	worker = std::thread(&ConvolutionReverb::workerThread, this);
+	loader = std::thread(&ConvolutionReverb::loaderThread, this);
+	running = true;
+}
+
+void ConvolutionReverb::stop()
+{
+	if (!worker.joinable() && !loader.joinable()) return;
+	running = false;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	workersignal.notify_all();
+	loadersignal.notify_all();
+	if (worker.joinable()) worker.join();
+	if (loader.joinable()) loader.join();
+}
+
+void ConvolutionReverb::wake()
+{
+	//taking the lock once between publishing and notifying means a thread that has already checked its
+	//condition is asleep by now and gets the notify; if the lock is busy, try again on the next sample
+	bool loadernotify = wakeloader.exchange(false);
+	if (!wakeworker && !loadernotify) return;
+	if (!lock.try_lock())
+	{
+		if (loadernotify) wakeloader = true;
+		return;
+	}
+	lock.unlock();
+	if (wakeworker) workersignal.notify_one();
+	if (loadernotify) loadersignal.notify_one();
+	wakeworker = false;
+}
+
+void ConvolutionReverb::requestcapture()
+{
+	requested = true;
+	if (!synchronous) wakeloader = true;  //delivered by the next ready( )
+}
+
+bool ConvolutionReverb::ready()
+{
+	if (synchronous)
+	{
+		if (requested) capturenow();
+	}
+	else
+	{
+		if (!running) return false;   //disabled: no worker would compute the tail
+		wake();
+	}
+	return active != nullptr || pending.load() != nullptr;
+}
+
+int ConvolutionReverb::latency()
+{
+	return B - advance;
+}
+
+int ConvolutionReverb::underruns()
+{
+	return missed;
+}
+
+ConvolutionReverb::Kernel* ConvolutionReverb::build(std::vector<float>& left, std::vector<float>& right)
+{
+	size_t length = left.size() < right.size() ? left.size() : right.size();
+	size_t limit = (size_t)(maxseconds * fs);
+	if (length > limit) length = limit;
+
+	//the known leading silence is skipped instead of showing up as latency
+	size_t silent = length < (size_t)advance ? length : (size_t)advance;
+
+	Kernel* k = new Kernel;
+	k->lastjob = -1;
+	int headlength = 2 * T;
+	int total = (int)(length - silent);
+	int taillength = total > headlength ? total - headlength : 0;
+	k->headparts = (total < headlength ? total + B - 1 : headlength) / B;
+	k->tailparts = (taillength + T - 1) / T;
+
+	const float* ir[2] = { &left[silent], &right[silent] };
+	for (int c = 0; c < 2; c++)
+	{
+		k->headre[c].assign((size_t)head.partitions * head.bins, 0.0);
+		k->headim[c].assign((size_t)head.partitions * head.bins, 0.0);
+		k->tailre[c].assign((size_t)(k->tailparts > 0 ? k->tailparts : 1) * tail.bins, 0.0);
+		k->tailim[c].assign((size_t)(k->tailparts > 0 ? k->tailparts : 1) * tail.bins, 0.0);
+		head.spectra(ir[c], total < headlength ? total : headlength, &k->headre[c][0], &k->headim[c][0]);
+		if (taillength > 0)
+			tail.spectra(ir[c] + headlength, taillength, &k->tailre[c][0], &k->tailim[c][0]);
+	}
+	return k;
+}
+
+void ConvolutionReverb::capturenow()
+{
+	requested = false;
+	std::vector<float> left, right;
+	if (!capture || !capture(fs, left, right)) return;
+	Kernel* k = build(left, right);
+	delete pending.exchange(k);  //never seen by the audio thread
+}
+
+void ConvolutionReverb::tailjob(int64_t job)
+{
+	int slot = (int)(job % slots);
+	int out = (int)((job + 2) % slots);   //the tail starts two tail blocks into the impulse response
+	Kernel* k = jobkernel[slot];   //a kernel without tail partitions still runs, to keep the input history
+	const double* hre[2] = { &k->tailre[0][0], &k->tailre[1][0] };
+	const double* him[2] = { &k->tailim[0][0], &k->tailim[1][0] };
+	tail.process(&tailin[(size_t)slot * T], hre, him, k->tailparts, &tailout[0][(size_t)out * T], &tailout[1][(size_t)out * T]);
+}
+
+void ConvolutionReverb::audioprocessing(double input, double& outL, double& outR)
+{
+	//a new impulse response takes over at a tail block boundary, together with the head; taken with one
+	//exchange, the loader may replace and free the pending kernel at any moment
+	if (sample % T == 0 && retired.load() == nullptr)
+	{
+		if (Kernel* k = pending.exchange(nullptr))
+		{
+			if (active)
+			{
+				active->lastjob = submitted - 1;
+				if (synchronous) delete active;
+				else retired.store(active);
+			}
+			active = k;
+		}
+	}
+	if (!active)
+	{
+		outL = outR = 0.0;
+		return;
+	}
+
+	//the tail for this output sample was computed from input at least two tail blocks older
+	int64_t t = sample - B;
+	outL = headout[0][headpos];
+	outR = headout[1][headpos];
+	if (t >= 2 * (int64_t)T)
+	{
+		int64_t block = t / T;
+		if (t % T == 0)
+		{
+			tailmissing = completed.load(std::memory_order_acquire) < block - 1;
+			if (tailmissing) missed++;
+		}
+		if (!tailmissing)
+		{
+			size_t i = (size_t)(block % slots) * T + (size_t)(t % T);
+			outL += tailout[0][i];
+			outR += tailout[1][i];
+		}
+	}
+
+	headin[headpos] = input;
+	tailin[(size_t)((sample / T) % slots) * T + (size_t)(sample % T)] = input;
+	sample++;
+
+	if (++headpos == B)
+	{
+		headpos = 0;
+		const double* hre[2] = { &active->headre[0][0], &active->headre[1][0] };
+		const double* him[2] = { &active->headim[0][0], &active->headim[1][0] };
+		head.process(&headin[0], hre, him, active->headparts, &headout[0][0], &headout[1][0]);
+	}
+
+	if (sample % T == 0)
+	{
+		int64_t job = sample / T - 1;
+		jobkernel[job % slots] = active;
+		if (synchronous)
+		{
+			tailjob(job);
+			completed.store(job + 1, std::memory_order_release);
+		}
+		else
+		{
+			submitted.store(job + 1, std::memory_order_release);
+			wakeworker = true;
+			wake();
+		}
+	}
+}
+
+void ConvolutionReverb::workerThread()
+{
+	int64_t done = completed;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			workersignal.wait(guard, [&] { return quit || submitted.load() > done; });
+			if (quit) return;
+		}
+		while (submitted.load(std::memory_order_acquire) > done)
+		{
+			tailjob(done);
+			completed.store(done + 1, std::memory_order_release);
+			done++;
+		}
+
+		//free the kernel the audio thread swapped out once no tail job can still read it
+		Kernel* old = retired.load();
+		if (old && done > old->lastjob)
+		{
+			retired.store(nullptr);
+			delete old;
+		}
+	}
+}
+
+void ConvolutionReverb::loaderThread()
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			loadersignal.wait(guard, [&] { return quit || requested.load(); });
+			if (quit) return;
+		}
+
+		if (requested)
+		{
+			//let a parameter drag settle before rendering
+			requested = false;
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			if (requested || quit) continue;
+
+			std::vector<float> left, right;
+			if (capture && capture(fs, left, right))
+				delete pending.exchange(build(left, right));
+		}
+	}
+}
@@ -0,0 +1,125 @@
+#ifndef Convolver_h
+#define Convolver_h
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "FFT.h"
+
+//one uniformly partitioned overlap-save level: mono input, stereo impulse response.
+//The input spectra sit in a frequency domain delay line and are multiplied with every partition
+class UniformConvolver {
+public:
+	UniformConvolver();
+	void setup(int _block, int _partitions);   //allocates
+	void reset();
+	void process(const double* input, const double* const* hre, const double* const* him, int parts, double* outL, double* outR);
+
+	//spectra of an impulse response cut into block sized partitions, bins values per partition
+	void spectra(const float* ir, int length, double* re, double* im);
+
+	int block;
+	int bins;        //block + 1, the rest of the spectrum is its mirror image
+	int partitions;
+
+private:
+	FFT fft;
+	std::vector<double> window;   //previous and current input block
+	std::vector<double> fdlre;
+	std::vector<double> fdlim;
+	std::vector<double> accre[2];
+	std::vector<double> accim[2];
+	std::vector<double> workre;
+	std::vector<double> workim;
+	int fdlpos;
+};
+
+//non-uniformly partitioned convolution reverb: short head partitions on the audio thread, long tail
+//partitions on a worker thread. The impulse response is captured through a callback on a loader
+//thread and swapped in at a tail block boundary, so nothing on the audio thread allocates or waits.
+//Both threads only exist while the convolver is enabled, and sleep until there is work
+class ConvolutionReverb {
+public:
+	typedef std::function<bool(double sampleRate, std::vector<float>& left, std::vector<float>& right)> Capture;
+
+	ConvolutionReverb();
+	~ConvolutionReverb();
+	void Buffersize(double sampleRate, int headblock, int lead);   //headblock a power of two; restarts the threads and allocates
+	void setcapture(Capture f);
+	void setsynchronous(bool a);     //capture and tail blocks on the calling thread, for offline rendering
+	void setenabled(bool a);         //not the audio thread: start or stop the worker and loader
+	void requestcapture();           //audio thread, cheap; the capture runs once the parameters settle
+	bool ready();                    //audio thread: an impulse response is loaded
+	void audioprocessing(double input, double& outL, double& outR);
+	int latency();                   //head block samples not covered by the lead, fixed by the configuration
+	int underruns();                 //tail blocks the worker did not finish in time
+
+	static const int tailfactor = 16;        //tail block = 16 head blocks
+	static const int slots = 4;              //tail input and output blocks in flight
+	static constexpr double maxseconds = 20.0; //long decays reach -120 dB well before this
+
+private:
+	struct Kernel {
+		int headparts;
+		int tailparts;
+		std::vector<double> headre[2];
+		std::vector<double> headim[2];
+		std::vector<double> tailre[2];
+		std::vector<double> tailim[2];
+		int64_t lastjob;               //last tail job that used this kernel, set when it is replaced
+	};
+
+	Kernel* build(std::vector<float>& left, std::vector<float>& right);
+	void start();
+	void stop();
+	void wake();      //audio thread: deliver notifies without ever waiting for the lock
+	void capturenow();
+	void tailjob(int64_t job);
+	void workerThread();
+	void loaderThread();
+
+	double fs;
+	int B;   //head block
+	int T;   //tail block
+	int advance;   //leading samples every impulse response is known to be silent for, up to one head block
+	UniformConvolver head;
+	UniformConvolver tail;
+
+	//audio thread
+	Kernel* active;
+	int64_t sample;
+	int headpos;
+	std::vector<double> headin;
+	std::vector<double> headout[2];
+	std::vector<double> tailin;       //slots blocks
+	std::vector<double> tailout[2];   //slots blocks
+	Kernel* jobkernel[slots];
+	bool tailmissing;
+	bool wakeworker;
+
+	//shared
+	Capture capture;
+	bool synchronous;
+	bool enabled;
+	std::mutex control;   //serializes start and stop between reset( ) and the GUI thread
+	std::atomic<Kernel*> pending;
+	std::atomic<Kernel*> retired;
+	std::atomic<bool> requested;
+	std::atomic<int64_t> submitted;
+	std::atomic<int64_t> completed;
+	std::atomic<int> missed;
+	std::atomic<bool> quit;
+	std::atomic<bool> running;
+	std::atomic<bool> wakeloader;
+	std::thread worker;
+	std::thread loader;
+	std::mutex lock;
+	std::condition_variable workersignal;
+	std::condition_variable loadersignal;
+};
+
+#endif
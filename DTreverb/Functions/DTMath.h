@@ -0,0 +1,171 @@
+#ifndef DTMath_h
+#define DTMath_h
+#include <string.h>
+#include <stdint.h>
+#include <cmath>
+
+//exp/log/pow/sin/cos for the audio and coefficient paths. libm differs in the last bit between
+//compilers and CPUs; with DTREVERB_DETERMINISTIC these are our own polynomials built from +,-,*,/
+//and exact bit operations only, evaluated in a fixed order, so a render is bit-identical on
+//every machine. Without the flag they are plain libm and nothing changes
+#ifdef DTREVERB_DETERMINISTIC
+
+//a fused multiply-add rounds once instead of twice, so contraction alone changes the output:
+//switched off for every translation unit that includes this. Keep -ffp-contract=off (/fp:precise)
+//on the command line as well, code included before this header is not covered by the pragma
+#if defined(__FAST_MATH__)
+#error "DTREVERB_DETERMINISTIC needs IEEE evaluation order, build without -ffast-math"
+#endif
+#if (defined(__FLT_EVAL_METHOD__) && __FLT_EVAL_METHOD__ != 0) || (defined(_M_IX86_FP) && _M_IX86_FP < 2)
+#error "DTREVERB_DETERMINISTIC needs SSE2 doubles, x87 extended precision rounds differently"
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma fp_contract (off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+//x * 2^k by building the power of two from its bits; split in two steps near the ends of the range
+inline double dtscale(double x, int k)
+{
+	while (k > 1023) { x *= 8.98846567431157953865e+307; k -= 1023; }  //2^1023
+	while (k < -1022) { x *= 2.22507385850720138309e-308; k += 1022; } //2^-1022
+	uint64_t bits = (uint64_t)(k + 1023) << 52;
+	double p;
+	memcpy(&p, &bits, sizeof(p));
+	return x * p;
+}
+
+inline double dtexp(double x)
+{
+	if (x != x) return x;
+	if (x > 709.782712893384) return HUGE_VAL;
+	if (x < -745.133219101941) return 0.0;
+
+	//x = k ln2 + r, |r| <= ln2/2; ln2 is split so that k * ln2hi is exact
+	double k = floor(x * 1.44269504088896338700 + 0.5);
+	double r = (x - k * 6.93147180369123816490e-01) - k * 1.90821492927058770002e-10;
+
+	//Taylor to r^13, last term below 1e-17 for |r| <= ln2/2
+	double p = 1.0 / 6227020800.0;
+	p = p * r + 1.0 / 479001600.0;
+	p = p * r + 1.0 / 39916800.0;
+	p = p * r + 1.0 / 3628800.0;
+	p = p * r + 1.0 / 362880.0;
+	p = p * r + 1.0 / 40320.0;
+	p = p * r + 1.0 / 5040.0;
+	p = p * r + 1.0 / 720.0;
+	p = p * r + 1.0 / 120.0;
+	p = p * r + 1.0 / 24.0;
+	p = p * r + 1.0 / 6.0;
+	p = p * r + 0.5;
+	p = p * r + 1.0;
+	p = p * r + 1.0;
+	return dtscale(p, (int)k);
+}
+
+inline double dtlog(double x)
+{
+	if (x != x || x < 0) return NAN;
+	if (x == 0) return -HUGE_VAL;
+	if (x == HUGE_VAL) return x;
+
+	//x = m 2^e, sqrt(1/2) <= m < sqrt(2)
+	int e = 0;
+	if (x < 2.22507385850720138309e-308) { x *= 18014398509481984.0; e = -54; }  //subnormal: 2^54
+	uint64_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	e += (int)((bits >> 52) & 0x7ff) - 1023;
+	bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+	double m;
+	memcpy(&m, &bits, sizeof(m));
+	if (m > 1.41421356237309504880) { m *= 0.5; e++; }
+
+	//log(m) = 2 atanh(f), f = (m-1)/(m+1), |f| <= 0.172; odd series to f^21
+	double f = (m - 1) / (m + 1);
+	double s = f * f;
+	double p = 1.0 / 21.0;
+	p = p * s + 1.0 / 19.0;
+	p = p * s + 1.0 / 17.0;
+	p = p * s + 1.0 / 15.0;
+	p = p * s + 1.0 / 13.0;
+	p = p * s + 1.0 / 11.0;
+	p = p * s + 1.0 / 9.0;
+	p = p * s + 1.0 / 7.0;
+	p = p * s + 1.0 / 5.0;
+	p = p * s + 1.0 / 3.0;
+	p = p * s + 1.0;
+	return e * 6.93147180369123816490e-01 + (e * 1.90821492927058770002e-10 + 2 * f * p);
+}
+
+inline double dtpow(double x, double y)
+{
+	if (y == 0 || x == 1) return 1.0;
+	if (x == 0) return y > 0 ? 0.0 : HUGE_VAL;
+	if (x < 0)
+	{
+		if (floor(y) != y) return NAN;
+		double a = dtexp(y * dtlog(-x));
+		return fmod(y, 2.0) != 0 ? -a : a;
+	}
+	return dtexp(y * dtlog(x));
+}
+
+//sin for quadrant 0 and 2, cos for 1 and 3 of x + shift * pi/2
+inline double dtsincos(double x, int shift)
+{
+	if (x != x || x == HUGE_VAL || x == -HUGE_VAL) return NAN;
+
+	//x = k pi/2 + r, |r| <= pi/4; pi/2 is split so that k * pio2hi is exact for |k| < 2^20
+	double k = floor(x * 6.36619772367581382433e-01 + 0.5);
+	double r = (x - k * 1.57079632673412561417e+00) - k * 6.07710050650619224932e-11;
+	double s = r * r;
+	int q = ((int)fmod(k, 4.0) + 4 + shift) & 3;
+
+	double v;
+	if (q & 1)
+	{
+		//cos, Taylor to r^18
+		double p = 1.0 / 6402373705728000.0;
+		p = -p * s + 1.0 / 20922789888000.0;
+		p = -p * s + 1.0 / 87178291200.0;
+		p = -p * s + 1.0 / 479001600.0;
+		p = -p * s + 1.0 / 3628800.0;
+		p = -p * s + 1.0 / 40320.0;
+		p = -p * s + 1.0 / 720.0;
+		p = -p * s + 1.0 / 24.0;
+		p = -p * s + 0.5;
+		v = 1.0 - p * s;
+	}
+	else
+	{
+		//sin, Taylor to r^17
+		double p = 1.0 / 355687428096000.0;
+		p = -p * s + 1.0 / 1307674368000.0;
+		p = -p * s + 1.0 / 6227020800.0;
+		p = -p * s + 1.0 / 39916800.0;
+		p = -p * s + 1.0 / 362880.0;
+		p = -p * s + 1.0 / 5040.0;
+		p = -p * s + 1.0 / 120.0;
+		p = -p * s + 1.0 / 6.0;
+		v = r - r * s * p;
+	}
+	return q & 2 ? -v : v;
+}
+
+inline double dtsin(double x) { return dtsincos(x, 0); }
+inline double dtcos(double x) { return dtsincos(x, 1); }
+
+#else
+
+inline double dtexp(double x) { return exp(x); }
+inline double dtlog(double x) { return log(x); }
+inline double dtpow(double x, double y) { return pow(x, y); }
+inline double dtsin(double x) { return sin(x); }
+inline double dtcos(double x) { return cos(x); }
+
+#endif
+
+#endif
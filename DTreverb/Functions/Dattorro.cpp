@@ -0,0 +1,15 @@
+#include "Dattorro.h"
+
+//storage for the tables, needed wherever they are indexed at run time
+constexpr double DattorroTopology::rate;
+constexpr int DattorroTopology::diffuser[4];
+constexpr int DattorroTopology::mallp[2];
+constexpr int DattorroTopology::excursion;
+constexpr double DattorroTopology::lforate;
+constexpr int DattorroTopology::delayA[2];
+constexpr int DattorroTopology::allpass[2];
+constexpr int DattorroTopology::delayB[2];
+constexpr int DattorroTopology::tapnode[DattorroTopology::taps];
+constexpr int DattorroTopology::tapdelay[DattorroTopology::taps];
+constexpr int DattorroTopology::left[DattorroTopology::sumterms];
+constexpr int DattorroTopology::right[DattorroTopology::sumterms];
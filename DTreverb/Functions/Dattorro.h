@@ -0,0 +1,358 @@
+#ifndef Dattorro_h
+#define Dattorro_h
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include "DTMath.h"
+#include <utility>
+#include "State.h"
+#include "ModAllpass.h"
+#include "Profile.h"
+
+//Dattorro plate topology, lengths in samples at the 29761 Hz of his paper.
+//Everything here is a compile-time constant; the tank below is built from it
+struct DattorroTopology {
+	static constexpr double rate = 29761;
+	static constexpr int predelay = 300;                        //reset value, the Predelay parameter overrides it
+	static constexpr int diffuser[4] = { 142, 107, 379, 277 };  //input allpasses apf1-4
+
+	//the two halves of the figure of eight, left then right
+	static constexpr int mallp[2] = { 672, 908 };       //modulated allpass at the input of each half
+	static constexpr int excursion = 8;                 //peak modulation of those two, 1 Hz in quadrature
+	static constexpr double lforate = 1.0;
+	static constexpr int delayA[2] = { 4453, 3163 };    //delay before the damping lowpass
+	static constexpr int allpass[2] = { 1800, 2656 };   //allpass after the decay
+	static constexpr int delayB[2] = { 3720, 4217 };    //delay feeding the other half
+
+	//output taps: node they read (0 delayA input, 1 allpass internal, 2 delayB input, 3-5 the same on the right) and delay
+	static constexpr int taps = 14;
+	static constexpr int tapnode[taps] = { 0, 0, 0, 1, 1, 2, 2, 3, 3, 3, 4, 4, 5, 5 };
+	static constexpr int tapdelay[taps] = { 353, 3627, 1990, 1228, 187, 2673, 1066, 121, 1996, 335, 1913, 2111, 2974, 266 };
+
+	//output sums: signed tap number (1-14) in summation order
+	static constexpr int sumterms = 7;
+	static constexpr int left[sumterms] = { 1, 2, -8, -4, -10, 6, -12 };
+	static constexpr int right[sumterms] = { 14, 13, -7, -11, -5, 9, -3 };
+
+	//average length of one half of the loop, the decay factor is applied once per half
+	static constexpr double halfloop()
+	{
+		return (mallp[0] + delayA[0] + allpass[0] + delayB[0] + mallp[1] + delayA[1] + allpass[1] + delayB[1]) * 0.5;
+	}
+};
+
+//figure of eight tank and output taps for a topology like the one above. All delays live in one
+//buffer; ring k starts at a compile-time offset times the sample rate scale, and every element is
+//inlined into audioprocessing instead of being a separate object
+template <class Topology>
+class DattorroTank {
+public:
+	DattorroTank();
+	~DattorroTank();
+	void reset();
+	void Buffersize(double sampleRate);
+	void audioprocessing(double inL, double inR, double& outL, double& outR);
+	void setgainparams(const double a);      //diffusion, modulated and tank allpasses
+	void setdampingparams(const double a);   //TLowpassFilter gain form: 1 = no damping
+	void setdecayparams(const double a);
+	void setfreeze(bool a);                  //unity decay and no damping
+	void setmodparams(const double a);       //0..1 of the topology's excursion
+	void setoversampling(int a);             //1, 2 or 4: rate the modulated allpasses run at
+	void tapout(double* out, int n);         //output taps of the last sample
+	void feedback(double& outL, double& outR);   //figure of eight feedback of the last sample, for metering
+	int statesize();
+	char* savestate(char* p);
+	const char* loadstate(const char* p, const char* end, bool apply);  //nullptr if the blob does not fit, apply = false only checks it
+
+	double gain;
+	double damping;
+	double decay;
+	double modulation;
+	bool frozen;
+#ifdef DTREVERB_PROFILE
+	StageProfile* profile;   //owner's histograms, null = not timed
+#endif
+
+private:
+	//rings 0-3 left half, 4-7 right half, then the output taps; the modulated allpasses (rings 0 and 4)
+	//keep their own buffers because they can run oversampled
+	enum { halfrings = 4, rings = 2 * halfrings + Topology::taps };
+
+	static constexpr int length(int k)
+	{
+		return k >= 2 * halfrings ? Topology::tapdelay[k - 2 * halfrings] :
+			(k % halfrings == 0 ? 0 :
+			k % halfrings == 1 ? Topology::delayA[k / halfrings] :
+			k % halfrings == 2 ? Topology::allpass[k / halfrings] : Topology::delayB[k / halfrings]);
+	}
+	static constexpr int start(int k) { return k == 0 ? 0 : start(k - 1) + length(k - 1); }
+
+	template <int k> double delay(double input, int lag = 0);   //lag shortens the delay
+	template <int k> double allp(double input, double& d_in);    //apf5/6 sign convention
+	template <int half> double half(double input, double mod);
+	template <int... k> void taps(std::integer_sequence<int, k...>);
+
+	double* dline;
+	int scale;          //round(sampleRate / Topology::rate), as for the separate delay objects
+	int bfsize;
+	double fs;
+	int wIndex[rings];
+	double lpfmem[2];
+	double tankout[2];  //figure of eight feedback, carried over to the next sample
+	double node[6];
+	double tap[Topology::taps];
+	ModAllpass modallp[2];
+	double lfophase;    //0..1
+};
+
+template <class Topology>
+DattorroTank<Topology>::DattorroTank()
+{
+	dline = nullptr;
+	bfsize = 0;
+	fs = 0;
+	gain = 0.5;
+	damping = 0.9;
+	decay = 0.5;
+	modulation = 0.0;
+	frozen = false;
+#ifdef DTREVERB_PROFILE
+	profile = nullptr;
+#endif
+	Buffersize(48000);
+}
+
+template <class Topology>
+DattorroTank<Topology>::~DattorroTank()
+{
+	delete[] dline;
+}
+
+template <class Topology>
+void DattorroTank<Topology>::reset()
+{
+	for (int k = 0; k < rings; k++) wIndex[k] = 0;
+	for (int i = 0; i < Topology::taps; i++) tap[i] = 0.0;
+	for (int i = 0; i < 6; i++) node[i] = 0.0;
+	lpfmem[0] = lpfmem[1] = 0.0;
+	tankout[0] = tankout[1] = 0.0;
+	lfophase = 0.0;
+	memset(dline, 0, bfsize * sizeof(double));
+	modallp[0].reset();
+	modallp[1].reset();
+}
+
+template <class Topology>
+void DattorroTank<Topology>::Buffersize(double sampleRate)
+{
+	if (dline && fs == sampleRate) { reset(); return; }
+
+	scale = (int)round(sampleRate / Topology::rate);
+	if (scale < 1) scale = 1;
+	bfsize = start(rings) * scale;
+	delete[] dline;
+	dline = new double[bfsize];
+	for (int h = 0; h < 2; h++)
+		modallp[h].Buffersize(sampleRate, Topology::mallp[h] * scale, Topology::excursion * scale);
+	fs = sampleRate;
+	reset();
+}
+
+template <class Topology>
+void DattorroTank<Topology>::setgainparams(const double a)
+{
+	gain = a;
+	modallp[0].setgainparams(a);
+	modallp[1].setgainparams(a);
+}
+
+template <class Topology>
+void DattorroTank<Topology>::setdampingparams(const double a) { damping = a; }
+
+template <class Topology>
+void DattorroTank<Topology>::setdecayparams(const double a) { decay = a; }
+
+template <class Topology>
+void DattorroTank<Topology>::setfreeze(bool a) { frozen = a; }
+
+template <class Topology>
+void DattorroTank<Topology>::setmodparams(const double a) { modulation = a; }
+
+template <class Topology>
+void DattorroTank<Topology>::setoversampling(int a)
+{
+	modallp[0].setfactor(a);
+	modallp[1].setfactor(a);
+}
+
+//ring length equals the delay, so the oldest sample sits at the write position
+template <class Topology> template <int k>
+inline double DattorroTank<Topology>::delay(double input, int lag)
+{
+	double* p = dline + start(k) * scale;
+	int r = wIndex[k] + lag;
+	if (r >= length(k) * scale) r -= length(k) * scale;
+	double out = p[r];
+	p[wIndex[k]] = input;
+	if (++wIndex[k] >= length(k) * scale) wIndex[k] = 0;
+	return out;
+}
+
+template <class Topology> template <int k>
+inline double DattorroTank<Topology>::allp(double input, double& d_in)
+{
+	double* p = dline + start(k) * scale + wIndex[k];
+	double d_out = *p;
+	d_in = input + d_out * -gain;
+	*p = d_in;
+	if (++wIndex[k] >= length(k) * scale) wIndex[k] = 0;
+	return d_in * gain + d_out;
+}
+
+//one half of the figure of eight: modulated allpass, delay, damping, decay, allpass, delay. The delay after
+//the allpass gives back whatever the oversampling stages add, so the loop keeps its length
+template <class Topology> template <int h>
+inline double DattorroTank<Topology>::half(double input, double mod)
+{
+	const int k = h * halfrings;
+	DT_PROFILE_START(t);
+	double modAPF = modallp[h].audioprocessing(input, mod);
+	node[3 * h] = modAPF;
+	DT_PROFILE_LAP(profile, prof_modallpass, t);
+	double delayLine = delay<k + 1>(modAPF, modallp[h].latency());
+	DT_PROFILE_LAP(profile, prof_tankdelays, t);
+	double lowpass = frozen ? delayLine : delayLine * damping + lpfmem[h] * (1 - damping);
+	if (!frozen) lpfmem[h] = lowpass;
+	double decayed = lowpass * (frozen ? 1.0 : decay);
+	DT_PROFILE_LAP(profile, prof_damping, t);
+	double APF = allp<k + 2>(decayed, node[3 * h + 1]);
+	node[3 * h + 2] = APF;
+	double out = delay<k + 3>(APF);
+	DT_PROFILE_LAP(profile, prof_tankdelays, t);
+	return out;
+}
+
+//every output tap in order, unrolled at compile time
+template <class Topology> template <int... k>
+inline void DattorroTank<Topology>::taps(std::integer_sequence<int, k...>)
+{
+	//taps on an allpass output give back the oversampling latency like the delay after it
+	int unroll[] = { (tap[k] = delay<2 * halfrings + k>(node[Topology::tapnode[k]],
+		Topology::tapnode[k] % 3 == 0 ? modallp[Topology::tapnode[k] / 3].latency() : 0), 0)... };
+	(void)unroll;
+}
+
+template <class Topology>
+void DattorroTank<Topology>::audioprocessing(double inL, double inR, double& outL, double& outR)
+{
+	double leftTankin = tankout[1] + inL;    // figure of 8 loop
+	double rightTankin = tankout[0] + inR;
+
+	//sine for the left allpass, cosine for the right
+	DT_PROFILE_START(t);
+	const double twopi = 6.283185307179586;
+	double modL = 0.0, modR = 0.0;
+	if (modulation > 0.0)
+	{
+		modL = modulation * dtsin(twopi * lfophase);
+		modR = modulation * dtcos(twopi * lfophase);
+		lfophase += Topology::lforate / fs;
+		if (lfophase >= 1.0) lfophase -= 1.0;
+	}
+	DT_PROFILE_LAP(profile, prof_modallpass, t);
+	tankout[0] = half<0>(leftTankin, modL);
+	tankout[1] = half<1>(rightTankin, modR);
+
+	DT_PROFILE_START(u);
+	taps(std::make_integer_sequence<int, Topology::taps>());
+
+	outL = tap[Topology::left[0] - 1];
+	outR = tap[Topology::right[0] - 1];
+	for (int i = 1; i < Topology::sumterms; i++)
+	{
+		int l = Topology::left[i];
+		int r = Topology::right[i];
+		outL = l > 0 ? outL + tap[l - 1] : outL - tap[-l - 1];
+		outR = r > 0 ? outR + tap[r - 1] : outR - tap[-r - 1];
+	}
+	DT_PROFILE_LAP(profile, prof_taps, u);
+}
+
+template <class Topology>
+void DattorroTank<Topology>::tapout(double* out, int n)
+{
+	for (int i = 0; i < n; i++)
+		out[i] = i < Topology::taps ? tap[i] : 0.0;
+}
+
+template <class Topology>
+void DattorroTank<Topology>::feedback(double& outL, double& outR)
+{
+	outL = tankout[0];
+	outR = tankout[1];
+}
+
+template <class Topology>
+int DattorroTank<Topology>::statesize()
+{
+	return (2 + rings) * sizeof(int) + 8 * sizeof(double) + bfsize * sizeof(double) + modallp[0].statesize() + modallp[1].statesize();
+}
+
+template <class Topology>
+char* DattorroTank<Topology>::savestate(char* p)
+{
+	p = putstate(p, bfsize);
+	p = putstate(p, scale);
+	for (int k = 0; k < rings; k++) p = putstate(p, wIndex[k]);
+	p = putstate(p, gain);
+	p = putstate(p, damping);
+	p = putstate(p, decay);
+	p = putstate(p, lpfmem[0]);
+	p = putstate(p, lpfmem[1]);
+	p = putstate(p, tankout[0]);
+	p = putstate(p, tankout[1]);
+	p = putstate(p, lfophase);
+	memcpy(p, dline, bfsize * sizeof(double));  //every ring is exactly as long as its delay, all of it is live
+	p += bfsize * sizeof(double);
+	p = modallp[0].savestate(p);
+	return modallp[1].savestate(p);
+}
+
+template <class Topology>
+const char* DattorroTank<Topology>::loadstate(const char* p, const char* end, bool apply)
+{
+	//the modulated allpasses are checked before the first change
+	if (apply && !loadstate(p, end, false)) return nullptr;
+
+	int size, s;
+	int w[rings];
+	double v[8];  //gain, damping, decay, lpfmem, tankout, lfophase
+	p = getstate(p, end, size);
+	p = getstate(p, end, s);
+	if (!p || size != bfsize || s != scale) return nullptr;
+	for (int k = 0; k < rings; k++)
+	{
+		//rings of the modulated allpasses have no length here, their index stays 0
+		p = getstate(p, end, w[k]);
+		if (!p || w[k] < 0 || w[k] >= (length(k) > 0 ? length(k) * scale : 1)) return nullptr;
+	}
+	p = getstate(p, end, v);
+	p = getring(p, end, dline, bfsize, 0, bfsize, apply);
+	p = modallp[0].loadstate(p, end, apply);
+	p = modallp[1].loadstate(p, end, apply);
+	if (p && apply)
+	{
+		for (int k = 0; k < rings; k++) wIndex[k] = w[k];
+		gain = v[0];
+		damping = v[1];
+		decay = v[2];
+		lpfmem[0] = v[3];
+		lpfmem[1] = v[4];
+		tankout[0] = v[5];
+		tankout[1] = v[6];
+		lfophase = v[7];
+	}
+	return p;
+}
+
+#endif
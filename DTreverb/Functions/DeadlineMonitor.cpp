@@ -0,0 +1,71 @@
+#include "DeadlineMonitor.h"
+#include <string.h>
+
+DeadlineMonitor::DeadlineMonitor()
+{
+	threshold = 0.8;
+	reset();
+}
+
+void DeadlineMonitor::reset()
+{
+	memset(history, 0, sizeof(history));
+	memset(count, 0, sizeof(count));
+	memset(above, 0, sizeof(above));
+	pos = 0;
+	filled = 0;
+	abovecount = 0;
+	p50 = p99 = max = nearmissrate = 0.0f;
+	nearmisses = 0;
+	overruns = 0;
+}
+
+void DeadlineMonitor::setthresholdparams(const double a)
+{
+	threshold = a;
+}
+
+//upper edge of the bin holding the rank-th smallest load (0 based)
+float DeadlineMonitor::percentile(int rank)
+{
+	int seen = 0;
+	for (int b = 0; b < bins; b++)
+	{
+		seen += count[b];
+		if (seen > rank) return (b + 1) * 0.01f;
+	}
+	return bins * 0.01f;
+}
+
+void DeadlineMonitor::measure(double seconds, uint32_t frames, double sampleRate)
+{
+	if (frames == 0 || sampleRate <= 0) return;
+	double load = seconds * sampleRate / frames;
+	int bin = (int)(load * 100);
+	if (bin >= bins) bin = bins - 1;
+	bool miss = load > threshold;
+
+	//the oldest call leaves the window once it is full
+	if (filled == window)
+	{
+		count[history[pos]]--;
+		abovecount -= above[pos];
+	}
+	else
+		filled++;
+	history[pos] = (uint16_t)bin;
+	above[pos] = miss;
+	count[bin]++;
+	abovecount += miss;
+	if (++pos == window) pos = 0;
+
+	if (miss) nearmisses++;
+	if (load > 1.0) overruns++;
+
+	p50 = percentile((filled - 1) / 2);
+	p99 = percentile((filled - 1) * 99 / 100);
+	int top = bins - 1;
+	while (top > 0 && count[top] == 0) top--;
+	max = (top + 1) * 0.01f;
+	nearmissrate = (float)abovecount / filled;
+}
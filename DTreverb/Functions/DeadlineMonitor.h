@@ -0,0 +1,38 @@
+#ifndef DeadlineMonitor_h
+#define DeadlineMonitor_h
+#include <stdint.h>
+
+//how close the buffer callbacks come to their deadline. Each call's wall time is taken as a load,
+//the fraction of numFrames / sampleRate it used, and filed into a fixed histogram of 1 % bins over a
+//rolling window of calls; percentiles are read off the histogram. Everything is preallocated and only
+//touched by the audio thread, so measuring needs no allocation and no lock
+class DeadlineMonitor {
+public:
+	DeadlineMonitor();
+	void reset();
+	void setthresholdparams(const double a);   //near-miss load, 0..1 of the deadline
+	void measure(double seconds, uint32_t frames, double sampleRate);
+
+	enum { window = 1024, bins = 401 };   //calls kept, 1 % bins up to 400 %, the last one holds everything above
+
+	//results for the window, fractions of the deadline (1 = the whole buffer period), for the meters
+	float p50;
+	float p99;
+	float max;
+	float nearmissrate;     //share of the window above the threshold
+	uint64_t nearmisses;    //since reset
+	uint64_t overruns;      //calls that took longer than the deadline, since reset
+	double threshold;
+
+private:
+	float percentile(int rank);
+
+	uint16_t history[window];   //bin of each call in the window, oldest at pos once full
+	uint32_t count[bins];
+	bool above[window];
+	int pos;
+	int filled;
+	int abovecount;
+};
+
+#endif
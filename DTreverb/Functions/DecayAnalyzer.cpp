@@ -0,0 +1,208 @@
+#define _USE_MATH_DEFINES
+#include "DecayAnalyzer.h"
+#include <cmath>
+#include <chrono>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static const float floorDb = -120.0f;
+
+DecayAnalyzer::DecayAnalyzer()
+	: published(0), middle(1), running(false)
+{
+	ring = new float[ringsize];
+	memset(ring, 0, ringsize * sizeof(float));
+	wIndex = 0;
+	rIndex = 0;
+	rt60 = 0.0;
+	enabled = false;
+	quit = false;
+	back = 0;
+	front = 2;
+	memset(frames, 0, sizeof(frames));
+	for (int i = 0; i < 3; i++) frames[i].fitindex = -1;
+
+	fft.setsize(fftsize);
+	re.resize(fftsize);
+	im.resize(fftsize);
+	power.assign(fftsize / 2, 0.0);
+	window.resize(fftsize);
+	for (int i = 0; i < fftsize; i++) window[i] = 0.5 - 0.5 * cos(2 * M_PI * i / fftsize);   //Hann
+	history.assign(AnalyzerFrame::points, floorDb);
+	Buffersize(48000);
+}
+
+DecayAnalyzer::~DecayAnalyzer()
+{
+	stop();
+	delete[] ring;
+}
+
+void DecayAnalyzer::Buffersize(double sampleRate)
+{
+	bool wasrunning = running;
+	stop();
+	fs = sampleRate;
+	framelength = (int)(fs / 100);
+	if (wasrunning) start();
+}
+
+void DecayAnalyzer::start()
+{
+	if (worker.joinable()) return;
+	//whatever is in the ring is old; start reading where the audio thread will write next
+	rIndex = published.load(std::memory_order_acquire);
+	framesum = 0.0;
+	framefill = 0;
+	rt60 = 0.0;
+	for (int i = 0; i < fftsize / 2; i++) power[i] = 0.0;
+	for (size_t i = 0; i < history.size(); i++) history[i] = floorDb;
+	quit = false;
+	running = true;
+	worker = std::thread(&DecayAnalyzer::workerThread, this);
+}
+
+void DecayAnalyzer::stop()
+{
+	if (!worker.joinable()) return;
+	running = false;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	signal.notify_all();
+	worker.join();
+}
+
+bool DecayAnalyzer::getframe(AnalyzerFrame*& frame)
+{
+	if (!(middle.load(std::memory_order_relaxed) & 4))
+	{
+		frame = &frames[front];
+		return false;
+	}
+	front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+	frame = &frames[front];
+	return true;
+}
+
+void DecayAnalyzer::workerThread()
+{
+	//below the audio and GUI threads: results may come late, the audio must not
+#ifdef _WIN32
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__APPLE__)
+	pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#elif defined(SCHED_IDLE)
+	sched_param param = {};
+	pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			signal.wait_for(guard, std::chrono::milliseconds(20), [&] { return quit; });
+			if (quit) return;
+		}
+		uint64_t end = published.load(std::memory_order_acquire);
+		if (end != rIndex) analyze(end);
+	}
+}
+
+void DecayAnalyzer::analyze(uint64_t end)
+{
+	//the audio thread never waits: if it lapped us, skip what it overwrote
+	if (end - rIndex > ringsize - fftsize) rIndex = end - (ringsize - fftsize);
+
+	//energy envelope in 10 ms frames
+	for (; rIndex < end; rIndex++)
+	{
+		double x = ring[rIndex & mask];
+		framesum += x * x;
+		if (++framefill == framelength)
+		{
+			double level = framesum / framelength;
+			history.erase(history.begin());
+			history.push_back(level > 1e-12 ? (float)(10 * log10(level)) : floorDb);
+			framesum = 0.0;
+			framefill = 0;
+		}
+	}
+
+	//spectrum of the newest fftsize samples, power smoothed over successive results
+	for (int i = 0; i < fftsize; i++)
+	{
+		re[i] = ring[(end - fftsize + i) & mask] * window[i];
+		im[i] = 0.0;
+	}
+	//the audio thread may have lapped us while we copied
+	if (published.load(std::memory_order_acquire) - end > ringsize - fftsize) return;
+	fft.forward(&re[0], &im[0]);
+	const double norm = 4.0 / ((double)fftsize * fftsize);   //Hann coherent gain 1/2, so a full scale sine reads 0 dB
+	for (int i = 0; i < fftsize / 2; i++)
+		power[i] = 0.7 * power[i] + 0.3 * (re[i] * re[i] + im[i] * im[i]) * norm;
+
+	AnalyzerFrame& frame = frames[back];
+	const double lo = 20.0, hi = 20000.0;
+	for (int b = 0; b < AnalyzerFrame::bands; b++)
+	{
+		double f0 = lo * pow(hi / lo, (double)b / AnalyzerFrame::bands);
+		double f1 = lo * pow(hi / lo, (double)(b + 1) / AnalyzerFrame::bands);
+		int k0 = (int)(f0 * fftsize / fs);
+		int k1 = (int)(f1 * fftsize / fs);
+		if (k1 <= k0) k1 = k0 + 1;
+		if (k1 > fftsize / 2) k1 = fftsize / 2;
+		double p = 0.0;
+		for (int k = k0; k < k1; k++) if (power[k] > p) p = power[k];   //peak of the band, narrow bands read like the bins
+		frame.spectrum[b] = p > 1e-12 ? (float)(10 * log10(p)) : floorDb;
+	}
+	for (int i = 0; i < AnalyzerFrame::points; i++) frame.decay[i] = history[i];
+	fitdecay(frame);
+
+	back = middle.exchange(back | 4, std::memory_order_acq_rel) & 3;
+}
+
+//T20 style fit: from the loudest frame, the first frames 5 dB and 25 dB down bound a least squares line
+//that is extrapolated to 60 dB. Long tails that have not fallen 25 dB yet are fitted over what there is
+//once it spans 10 dB, so the estimate follows the decay as it happens. The last good value is kept while
+//the signal does not decay
+void DecayAnalyzer::fitdecay(AnalyzerFrame& frame)
+{
+	const int n = AnalyzerFrame::points;
+	int peak = 0;
+	for (int i = 1; i < n; i++) if (history[i] >= history[peak]) peak = i;
+
+	int a = -1, b = -1;
+	for (int i = peak; i < n; i++)
+	{
+		if (a < 0 && history[i] <= history[peak] - 5) a = i;
+		if (history[i] <= history[peak] - 25) { b = i; break; }
+	}
+	if (b < 0 && a >= 0 && history[n - 1] <= history[peak] - 15) b = n - 1;
+
+	frame.rt60 = (float)rt60;
+	frame.fitindex = -1;
+	if (history[peak] <= floorDb + 30 || a < 0 || b <= a + 1) return;
+
+	//least squares over the frames between the two crossings
+	double sx = 0, sy = 0, sxx = 0, sxy = 0;
+	int m = b - a + 1;
+	for (int i = a; i <= b; i++)
+	{
+		double t = (i - a) * 0.01;
+		sx += t; sy += history[i]; sxx += t * t; sxy += t * history[i];
+	}
+	double slope = (m * sxy - sx * sy) / (m * sxx - sx * sx);   //dB per second
+	if (slope >= 0) return;
+	rt60 = -60.0 / slope;
+	frame.rt60 = (float)rt60;
+	frame.fitslope = (float)slope;
+	frame.fitstart = (float)((sy - slope * sx) / m);
+	frame.fitindex = a;
+}
@@ -0,0 +1,86 @@
+#ifndef DecayAnalyzer_h
+#define DecayAnalyzer_h
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include "FFT.h"
+
+//one analysis result for the GUI: smoothed spectrum, level history and the decay fit
+struct AnalyzerFrame {
+	enum { bands = 96, points = 800 };   //log spaced 20 Hz - 20 kHz; 10 ms energy frames, 8 s
+	float spectrum[bands];   //dB
+	float decay[points];     //dB, oldest first
+	float rt60;              //seconds, 0 until a decay has been measured
+	float estimate;          //closed form broadband RT60 of the settings, filled in by the core; negative = infinite
+	float fitstart;          //fitted line for the view: level at the first fitted point and dB per second,
+	float fitslope;          //starting at decay[fitindex]
+	int fitindex;            //-1 when the current history has no decay to fit
+};
+
+//spectrum and live RT60 of the wet signal. The audio thread only copies samples into a ring and
+//publishes its write position once per buffer; a low priority worker thread does the FFT, the energy
+//envelope and the decay fit, and hands results to the GUI through a triple buffer. Nothing runs and
+//nothing is copied while the analyzer is stopped
+class DecayAnalyzer {
+public:
+	DecayAnalyzer();
+	~DecayAnalyzer();
+	void Buffersize(double sampleRate);   //restarts the worker if it runs
+
+	//GUI thread
+	void start();
+	void stop();
+	bool getframe(AnalyzerFrame*& frame);   //true when there is a new result; frame stays valid until the next call
+
+	//audio thread
+	void beginbuffer() { enabled = running.load(std::memory_order_relaxed); }
+	inline void audioprocessing(double input)
+	{
+		if (!enabled) return;
+		ring[wIndex & mask] = (float)input;
+		wIndex++;
+	}
+	void endbuffer() { if (enabled) published.store(wIndex, std::memory_order_release); }
+
+	enum { ringsize = 1 << 16, fftsize = 4096 };
+
+private:
+	void workerThread();
+	void analyze(uint64_t end);
+	void fitdecay(AnalyzerFrame& frame);
+
+	//audio thread
+	float* ring;
+	static const uint64_t mask = ringsize - 1;
+	uint64_t wIndex;
+	bool enabled;
+	std::atomic<uint64_t> published;
+
+	//worker
+	double fs;
+	uint64_t rIndex;
+	int framelength;      //samples per 10 ms energy frame
+	double framesum;
+	int framefill;
+	std::vector<double> re, im, window, power;
+	std::vector<float> history;   //energy frames in dB, oldest first
+	double rt60;                  //last successful fit
+	FFT fft;
+
+	//triple buffer: the worker fills back, swaps it with middle; the GUI swaps middle with front
+	AnalyzerFrame frames[3];
+	int back;
+	int front;
+	std::atomic<int> middle;   //index, plus 4 when it holds a result the GUI has not taken
+
+	std::atomic<bool> running;
+	bool quit;
+	std::thread worker;
+	std::mutex lock;
+	std::condition_variable signal;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#define _USE_MATH_DEFINES
+#include "DecayEstimator.h"
+#include "Dattorro.h"
+#include "FDN.h"
+#include <cmath>
+
+const double DecayEstimator::centre[DecayEstimator::bands] = { 31.5, 63, 125, 250, 500, 1000, 2000, 4000, 8000, 16000 };
+constexpr double DecayEstimator::maxtail;
+
+DecayEstimator::DecayEstimator()
+{
+	settings.sampleRate = 0;   //nothing computed yet
+	for (int i = 0; i < bands; i++) band[i] = 0.0;
+	broadband = 0.0;
+	tail = 0.0;
+	infinite = false;
+	decaypass = damppass = 0.0;
+}
+
+double DecayEstimator::rt60(double frequency) const
+{
+	if (infinite) return -1.0;
+	double fs = settings.sampleRate;
+	if (frequency > 0.45 * fs) frequency = 0.45 * fs;
+	double w = 2 * M_PI * frequency / fs;
+	double d = settings.damping;
+	double pole = 1 - d;
+	double magnitude = d / sqrt(1 - 2 * pole * cos(w) + pole * pole);
+
+	//dB lost per second through the decay factor and through the lowpass
+	double loss = -20 * log10(settings.decay) / decaypass - 20 * log10(magnitude) / damppass;
+	return loss > 0 ? 60.0 / loss : 0.0;
+}
+
+void DecayEstimator::compute(const DecaySettings& s)
+{
+	settings = s;
+	double fs = s.sampleRate;
+	double scale = round(fs / DattorroTopology::rate);   //same conversion the delay objects use
+	if (scale < 1) scale = 1;
+
+	//the FDN applies the decay factor per half Dattorro loop of delay, like the tank, but damps once per
+	//line, so its lowpass is passed more often
+	decaypass = DattorroTopology::halfloop() * scale / fs;
+	damppass = s.lines > 0 ? FDN::meanlength(s.lines) * scale / fs : decaypass;
+
+	infinite = s.frozen || s.decay >= 1.0;   //DC never decays
+	if (s.decay <= 0.0 && !s.frozen)
+	{
+		//nothing recirculates, only the diffusers ring
+		infinite = false;
+		for (int i = 0; i < bands; i++) band[i] = 0.0;
+		broadband = 0.0;
+	}
+	else
+	{
+		for (int i = 0; i < bands; i++) band[i] = rt60(centre[i]);
+		broadband = (band[4] + band[5]) * 0.5;
+	}
+
+	//every allpass round trip is scaled by the diffusion
+	const double diffuser = DattorroTopology::diffuser[0] + DattorroTopology::diffuser[1] + DattorroTopology::diffuser[2] + DattorroTopology::diffuser[3];
+	double smear = s.diffusion > 0 ? diffuser * scale * log(1e-3) / log(s.diffusion) / fs : 0.0;
+
+	double slowest = 0.0;
+	for (int i = 0; i < bands; i++) if (band[i] > slowest) slowest = band[i];
+	tail = infinite ? maxtail : s.predelay + smear + slowest;
+	if (tail > maxtail) tail = maxtail;
+}
@@ -0,0 +1,48 @@
+#ifndef DecayEstimator_h
+#define DecayEstimator_h
+#include <stdio.h>
+
+//everything the decay of the wet path depends on
+struct DecaySettings {
+	double sampleRate = 48000;
+	double decay = 0.5;       //decay factor, once per half of the figure of eight
+	double damping = 0.5;     //one pole lowpass gain form: 1 = no damping
+	double diffusion = 0.5;   //input allpass gain
+	double predelay = 0.0;    //seconds
+	int lines = 0;            //0 = Dattorro tank, otherwise FDN lines
+	bool frozen = false;
+
+	bool operator==(const DecaySettings& a) const
+	{
+		return sampleRate == a.sampleRate && decay == a.decay && damping == a.damping && diffusion == a.diffusion &&
+			predelay == a.predelay && lines == a.lines && frozen == a.frozen;
+	}
+	bool operator!=(const DecaySettings& a) const { return !(*this == a); }
+};
+
+//closed form decay times of the tank, no impulse response needed. Every pass through a loop segment
+//multiplies by the decay factor and by the damping lowpass |H(f)| = d / |1 - (1 - d) e^-jw|; the loop
+//allpasses and the modulation are lossless. RT60(f) is the time for those losses to add up to 60 dB
+class DecayEstimator {
+public:
+	enum { bands = 10 };
+	static const double centre[bands];   //octave bands, 31.5 Hz to 16 kHz
+
+	DecayEstimator();
+	void compute(const DecaySettings& s);
+	double rt60(double frequency) const;   //seconds; -1 when infinite is set, 0 is a decay factor of 0
+
+	DecaySettings settings;   //what the results were computed for
+	double band[bands];       //RT60 per octave band, seconds, -1 when infinite
+	double broadband;         //mean of the 500 Hz and 1 kHz bands
+	double tail;              //predelay and diffuser smear plus the slowest band, capped at maxtail
+	bool infinite;            //frozen or a decay factor of 1
+
+	static constexpr double maxtail = 60.0;
+
+private:
+	double decaypass;   //seconds per decay factor
+	double damppass;    //seconds per damping lowpass
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include "DelayLine.h"
+#include "DTMath.h"
+#include "State.h"
 #include <cmath>
 delayline::delayline()
 //constructor
@@ -24,6 +26,7 @@ void delayline::reset()
 }
 void delayline::Buffersize(double samplingRate)
 {
+	if (bfsize == (int)samplingRate) { reset(); return; } //same rate, keep the buffer (offline workers reset between files)
 	delete[] dline;
 	bfsize = samplingRate;
 	dline = new double[bfsize];  //reset buffersize for each delayline
@@ -54,6 +57,50 @@ double delayline::getdelayparams()
 }
 
 
+int delayline::statesize()
+//size of the snapshot: indices, last outputs and the part of the buffer still ahead of the read pointer
+{
+	int history = (delay > 0 && delay <= bfsize) ? delay : bfsize; //a zero delay reads one full buffer back
+	return 4 * sizeof(int) + 2 * sizeof(double) + history * sizeof(double);
+}
+
+char* delayline::savestate(char* p)
+{
+	int history = (delay > 0 && delay <= bfsize) ? delay : bfsize;
+	p = putstate(p, bfsize);
+	p = putstate(p, delay);
+	p = putstate(p, wIndex);
+	p = putstate(p, rIndex);
+	p = putstate(p, out);
+	p = putstate(p, tap);
+	return putring(p, dline, bfsize, wIndex, history);
+}
+
+const char* delayline::loadstate(const char* p, const char* end, bool apply)
+//restores into the existing buffer, no allocation; the blob is checked before anything changes
+{
+	int size, d, w, r;
+	double o, t;
+	p = getstate(p, end, size);
+	p = getstate(p, end, d);
+	p = getstate(p, end, w);
+	p = getstate(p, end, r);
+	p = getstate(p, end, o);
+	p = getstate(p, end, t);
+	if (!p || size != bfsize || d < 0 || d > bfsize || r < 0 || r >= bfsize) return nullptr;
+	int history = d > 0 ? d : bfsize;
+	p = getring(p, end, dline, bfsize, w, history, apply);
+	if (p && apply)
+	{
+		delay = d;
+		wIndex = w;
+		rIndex = r;
+		out = o;
+		tap = t;
+	}
+	return p;
+}
+
 double delayline::audioprocessing(double input)
 {
 	rIndex = wIndex - delay; //read pointer to set a delay time
@@ -16,6 +16,9 @@ class delayline{
 		double delayout(void);
 		void setdelayparams(const int a);
 		double getdelayparams();
+		int statesize();
+		char* savestate(char* p);
+		const char* loadstate(const char* p, const char* end, bool apply); //nullptr if the blob does not fit this buffer, apply = false only checks it
 		double delaymsec;
 		int fsConverted;
 		int delay;
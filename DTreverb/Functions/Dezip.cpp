@@ -1,4 +1,6 @@
 #include "Dezip.h"
+#include "DTMath.h"
+#include "State.h"
 DeZipper::DeZipper()
 {
 	DZMM = 0.0;
@@ -11,4 +13,21 @@ double DeZipper::smooth(double sample) {
 	DZMM = temp;
 
 	return temp;
+}
+void DeZipper::reset(double value) {
+	DZMM = value;
+}
+int DeZipper::statesize() {
+	return sizeof(double);
+}
+
+char* DeZipper::savestate(char* p) {
+	return putstate(p, DZMM);
+}
+
+const char* DeZipper::loadstate(const char* p, const char* end, bool apply) {
+	double value;
+	p = getstate(p, end, value);
+	if (p && apply) DZMM = value;
+	return p;
 }
\ No newline at end of file
@@ -7,6 +7,10 @@ class DeZipper {
 public:
 	DeZipper();
 	double smooth(double sample);
+	void reset(double value);  //jump to value, no fade
+	int statesize();
+	char* savestate(char* p);
+	const char* loadstate(const char* p, const char* end, bool apply);
 private:
 	double DZMM;
 	double DZFB;
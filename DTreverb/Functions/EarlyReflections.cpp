@@ -0,0 +1,182 @@
+#define _USE_MATH_DEFINES
+#include "EarlyReflections.h"
+#include "DTMath.h"
+#include "State.h"
+#include "Simd.h"
+#include "Dattorro.h"
+#include <cmath>
+
+//arrival times in samples at the topology rate, denser towards the end like a room's reflections
+static const int reflection[EarlyReflections::taps] = {
+	276, 489, 660, 760, 879, 967, 1044, 1133, 1197, 1274, 1333, 1396, 1462, 1526, 1570, 1625,
+	1683, 1738, 1781, 1826, 1881, 1913, 1968, 2004, 2044, 2085, 2128, 2174, 2206, 2249, 2288, 2322 };
+
+//-1 = hard left, 1 = hard right
+static const double pan[EarlyReflections::taps] = {
+	0.1, -0.87, -0.88, -0.59, 0.36, -0.14, -0.37, 0.17, -0.09, -0.4, 0.59, 0.4, -0.51, 0.15, 0.05, 0.75,
+	0.46, -0.42, 0.96, -0.76, -0.16, 0.51, -0.7, -0.02, -0.92, 0.34, 0.53, 0.15, 0.75, -0.37, 0.39, 0.19 };
+
+EarlyReflections::EarlyReflections()
+{
+	ring = nullptr;
+	fs = 0;
+	predelay = 0;
+	cutoff = 200;
+	level = 0.0;
+	lpfgain = 0.9;
+	Buffersize(48000);
+}
+
+EarlyReflections::~EarlyReflections()
+{
+	delete[] ring;
+}
+
+void EarlyReflections::reset()
+{
+	wIndex = 0;
+	lpfmem[0] = lpfmem[1] = 0.0;
+	memset(ring, 0, (mask + 1) * sizeof(double));
+}
+
+void EarlyReflections::Buffersize(double sampleRate)
+{
+	if (ring && fs == sampleRate) { reset(); return; }
+
+	int fsConverted = (int)round(sampleRate / DattorroTopology::rate);
+	int longest = 0;
+	for (int k = 0; k < taps; k++)
+	{
+		tapdelay[k] = reflection[k] * fsConverted;
+		if (tapdelay[k] > longest) longest = tapdelay[k];
+	}
+
+	//the tank's first output arrives after the input diffuser and the shortest output tap,
+	//the reflections hand over to it between there and twice that
+	int firsttap = DattorroTopology::tapdelay[0];
+	for (int i = 1; i < DattorroTopology::taps; i++)
+		if (DattorroTopology::tapdelay[i] < firsttap) firsttap = DattorroTopology::tapdelay[i];
+	double onset = DattorroTopology::diffuser[0] + DattorroTopology::diffuser[1] + DattorroTopology::diffuser[2] + DattorroTopology::diffuser[3] + firsttap;
+
+	double energy = 0.0;
+	for (int k = 0; k < taps; k++)
+	{
+		double t = reflection[k];
+		double fade = t < onset ? 1.0 : t < 2 * onset ? 0.5 + 0.5 * dtcos(M_PI * (t - onset) / onset) : 0.0;
+		double a = fade / (1 + 4 * t / onset);  //1/distance
+		double sign = (k % 3 == 1) ? -1.0 : 1.0;
+		shape[2 * k] = sign * a * dtcos(M_PI / 4 * (1 + pan[k]));
+		shape[2 * k + 1] = sign * a * dtsin(M_PI / 4 * (1 + pan[k]));
+		energy += shape[2 * k] * shape[2 * k] + shape[2 * k + 1] * shape[2 * k + 1];
+	}
+	for (int k = 0; k < 2 * taps; k++)
+		shape[k] /= sqrt(energy / 2);  //unit energy per channel
+
+	//predelay up to one second, as in the mono path
+	int size = 1;
+	while (size < (int)sampleRate + longest + 1) size *= 2;
+	delete[] ring;
+	ring = new double[size];
+	mask = size - 1;
+	fs = sampleRate;
+	setcutoffparams(cutoff);
+	setgains();
+	reset();
+}
+
+void EarlyReflections::setdelayparams(const int a)
+{
+	predelay = a < 0 ? 0 : a > (int)fs ? (int)fs : a;
+}
+
+void EarlyReflections::setcutoffparams(const double a)
+{
+	cutoff = a;
+	lpfgain = dtexp(-2 * M_PI * (cutoff / fs));  //same one pole as LowpassFilter
+}
+
+void EarlyReflections::setcutoffparams(const double a, const double g)
+{
+	cutoff = a;
+	lpfgain = g;
+}
+
+void EarlyReflections::setlevelparams(const double a)
+{
+	level = a;
+	setgains();
+}
+
+void EarlyReflections::setgains()
+{
+	for (int k = 0; k < 2 * taps; k++)
+		tapgain[k] = shape[k] * level;
+}
+
+void EarlyReflections::audioprocessing(double input, double& outL, double& outR)
+{
+	ring[wIndex] = input;
+	if (level == 0.0)
+	{
+		//keep the history so turning the level up does not replay old input
+		wIndex = (wIndex + 1) & mask;
+		lpfmem[0] = lpfmem[1] = 0.0;
+		outL = outR = 0.0;
+		return;
+	}
+
+	//two accumulators so consecutive taps do not wait on each other
+	dpair acc0 = pairset1(0.0);
+	dpair acc1 = pairset1(0.0);
+	int base = wIndex - predelay;
+	for (int k = 0; k < taps; k += 2)
+	{
+		acc0 = pairadd(acc0, pairmul(pairset1(ring[(base - tapdelay[k]) & mask]), pairload(tapgain + 2 * k)));
+		acc1 = pairadd(acc1, pairmul(pairset1(ring[(base - tapdelay[k + 1]) & mask]), pairload(tapgain + 2 * k + 2)));
+	}
+	wIndex = (wIndex + 1) & mask;
+
+	//bandwidth lowpass on the sum, the same cutoff as the tank input
+	dpair g = pairset1(lpfgain);
+	dpair x = pairadd(pairmul(pairadd(acc0, acc1), pairsub(pairset1(1.0), g)), pairmul(pairload(lpfmem), g));
+	pairstore(lpfmem, x);
+
+	outL = pairlo(x);
+	outR = pairhi(x);
+}
+
+int EarlyReflections::statesize()
+{
+	return 3 * sizeof(int) + 2 * sizeof(double) + (predelay + tapdelay[taps - 1] + 1) * sizeof(double);
+}
+
+char* EarlyReflections::savestate(char* p)
+{
+	p = putstate(p, mask);
+	p = putstate(p, predelay);
+	p = putstate(p, wIndex);
+	p = putstate(p, lpfmem[0]);
+	p = putstate(p, lpfmem[1]);
+	return putring(p, ring, mask + 1, wIndex, predelay + tapdelay[taps - 1] + 1);
+}
+
+const char* EarlyReflections::loadstate(const char* p, const char* end, bool apply)
+{
+	int size, d, w;
+	double mem[2];
+	p = getstate(p, end, size);
+	p = getstate(p, end, d);
+	p = getstate(p, end, w);
+	p = getstate(p, end, mem[0]);
+	p = getstate(p, end, mem[1]);
+	if (!p || size != mask || d < 0 || d > (int)fs) return nullptr;
+	p = getring(p, end, ring, mask + 1, w, d + tapdelay[taps - 1] + 1, apply);
+	if (p && apply)
+	{
+		predelay = d;
+		wIndex = w;
+		lpfmem[0] = mem[0];
+		lpfmem[1] = mem[1];
+	}
+	return p;
+}
@@ -0,0 +1,44 @@
+#ifndef EarlyReflections_h
+#define EarlyReflections_h
+#include <stdio.h>
+#include <string.h>
+
+//sparse FIR of early reflections that runs beside the tank. All taps read one mono ring and carry a
+//left/right gain pair, so a tap is one load and one 2-wide multiply-add. The taps fade out over the
+//window in which the tank's first output taps come in, which is the crossfade into the late tail
+class EarlyReflections {
+public:
+	EarlyReflections();
+	~EarlyReflections();
+	void reset();
+	void Buffersize(double sampleRate);
+	void audioprocessing(double input, double& outL, double& outR);
+	void setdelayparams(const int a);     //predelay in samples, the reflections follow it like the tank does
+	void setcutoffparams(const double a);
+	void setcutoffparams(const double a, const double g);  //one pole gain cooked by the caller
+	void setlevelparams(const double a);  //0..1
+	int statesize();
+	char* savestate(char* p);
+	const char* loadstate(const char* p, const char* end, bool apply);
+
+	static const int taps = 32;
+
+	double cutoff;
+	double level;
+
+private:
+	void setgains();
+
+	double* ring;            //power of two, predelay plus the longest tap
+	int mask;
+	int wIndex;
+	int predelay;
+	int tapdelay[taps];      //samples after the predelay
+	double tapgain[2 * taps];   //left/right pairs, level and fade included
+	double shape[2 * taps];     //tapgain before level
+	double fs;
+	double lpfgain;
+	double lpfmem[2];
+};
+
+#endif
@@ -0,0 +1,221 @@
+#include "FDN.h"
+#include "DTMath.h"
+#include "State.h"
+#include "Dattorro.h"
+#include <cmath>
+
+//mutually prime lengths at 29761 Hz, spread evenly enough that every subset of 4 or 8 covers the range
+static const int fdnlength[FDN::maxlines] = {
+	557, 3469, 1213, 2281, 887, 2833, 1601, 3821, 661, 3137, 1399, 2039, 1051, 2549, 1811, 4079 };
+
+FDN::FDN()
+{
+	dline = nullptr;
+	bfsize = 0;
+	fs = 0;
+	lines = 8;
+	matrix = hadamard;
+	decay = 0.5;
+	gain = 0.5;
+	frozen = false;
+	Buffersize(48000);
+}
+
+FDN::~FDN()
+{
+	delete[] dline;
+}
+
+void FDN::reset()
+{
+	for (int i = 0; i < maxlines; i++)
+	{
+		wIndex[i] = 0;
+		lpfmem[i] = 0.0;
+		lineout[i] = 0.0;
+	}
+	memset(dline, 0, bfsize * sizeof(double));
+}
+
+void FDN::Buffersize(double sampleRate)
+{
+	if (dline && fs == sampleRate) { reset(); return; }
+
+	int fsConverted = (int)round(sampleRate / DattorroTopology::rate);  //same conversion as the Dattorro delays
+	if (fsConverted < 1) fsConverted = 1;
+	bfsize = 0;
+	for (int i = 0; i < maxlines; i++)
+	{
+		size[i] = fdnlength[i] * fsConverted;
+		offset[i] = bfsize;
+		bfsize += size[i];
+	}
+
+	delete[] dline;
+	dline = new double[bfsize];
+	fs = sampleRate;
+	setdecayparams(decay);
+	reset();
+}
+
+void FDN::setlines(int a)
+{
+	int n = a >= 16 ? 16 : (a >= 8 ? 8 : 4);
+	if (n == lines) return;
+	lines = n;
+	setdecayparams(decay);
+	reset();  //lines that drop out must not come back with old contents
+}
+
+void FDN::setmatrix(int a)
+{
+	matrix = a == householder ? householder : hadamard;
+}
+
+void FDN::setdecayparams(double a)
+{
+	decay = a;
+	decaycoefficients(fs, decay, feedback);
+}
+
+void FDN::setdecayparams(double a, const double* cooked)
+{
+	decay = a;
+	memcpy(feedback, cooked, sizeof(feedback));
+}
+
+void FDN::decaycoefficients(double sampleRate, double a, double* feedback)
+{
+	int fsConverted = (int)round(sampleRate / DattorroTopology::rate);
+	if (fsConverted < 1) fsConverted = 1;
+	for (int i = 0; i < maxlines; i++)
+		feedback[i] = dtpow(a, (double)(fdnlength[i] * fsConverted) / (DattorroTopology::halfloop() * fsConverted)); //equal decay per second on every line, half a Dattorro loop per DF
+}
+
+double FDN::meanlength(int n)
+{
+	double sum = 0.0;
+	for (int i = 0; i < n; i++) sum += fdnlength[i];
+	return n > 0 ? sum / n : 0.0;
+}
+
+void FDN::setgainparams(double a)
+{
+	gain = a;
+}
+
+void FDN::setfreeze(bool a)
+{
+	frozen = a;
+}
+
+void FDN::audioprocessing(double inL, double inR, double& outL, double& outR)
+{
+	const double norm = sqrt(2.0 / lines);
+	outL = outR = 0.0;
+
+	//read the lines, damp and scale them; output signs are two orthogonal Hadamard rows
+	for (int i = 0; i < lines; i++)
+	{
+		double o = dline[offset[i] + wIndex[i]];
+		lineout[i] = o;
+		outL += (i & 1) ? -o : o;
+		outR += (i & 2) ? -o : o;
+
+		if (frozen)
+		{
+			x[i] = o;
+		}
+		else
+		{
+			lpfmem[i] = o * gain + lpfmem[i] * (1 - gain);
+			x[i] = lpfmem[i] * feedback[i];
+		}
+	}
+	outL *= norm;
+	outR *= norm;
+
+	//orthogonal mix, O(N log N) for Hadamard and O(N) for Householder
+	if (matrix == hadamard)
+	{
+		for (int h = 1; h < lines; h *= 2)
+			for (int i = 0; i < lines; i += 2 * h)
+				for (int j = i; j < i + h; j++)
+				{
+					double a = x[j];
+					double b = x[j + h];
+					x[j] = a + b;
+					x[j + h] = a - b;
+				}
+		double scale = 1.0 / sqrt((double)lines);
+		for (int i = 0; i < lines; i++) x[i] *= scale;
+	}
+	else
+	{
+		double sum = 0.0;
+		for (int i = 0; i < lines; i++) sum += x[i];
+		sum *= 2.0 / lines;
+		for (int i = 0; i < lines; i++) x[i] -= sum;
+	}
+
+	//left input to even lines, right to odd, alternating signs so the two stay apart
+	for (int i = 0; i < lines; i++)
+	{
+		double in = (i & 1) ? inR : inL;
+		dline[offset[i] + wIndex[i]] = x[i] + ((i & 2) ? -in : in);
+		if (++wIndex[i] >= size[i]) wIndex[i] = 0;
+	}
+}
+
+void FDN::tapout(double* out, int n)
+{
+	for (int k = 0; k < n; k++)
+		out[k] = lineout[k % lines];
+}
+
+int FDN::statesize()
+{
+	return sizeof(int) * (1 + maxlines) + 2 * maxlines * sizeof(double) + bfsize * sizeof(double);
+}
+
+char* FDN::savestate(char* p)
+{
+	p = putstate(p, bfsize);
+	for (int i = 0; i < maxlines; i++)
+	{
+		p = putstate(p, wIndex[i]);
+		p = putstate(p, lpfmem[i]);
+		p = putstate(p, lineout[i]);
+	}
+	memcpy(p, dline, bfsize * sizeof(double));
+	return p + bfsize * sizeof(double);
+}
+
+const char* FDN::loadstate(const char* p, const char* end, bool apply)
+{
+	int total;
+	int w[maxlines];
+	double mem[maxlines];
+	double o[maxlines];
+	p = getstate(p, end, total);
+	if (!p || total != bfsize) return nullptr;
+	for (int i = 0; i < maxlines; i++)
+	{
+		p = getstate(p, end, w[i]);
+		p = getstate(p, end, mem[i]);
+		p = getstate(p, end, o[i]);
+		if (!p || w[i] < 0 || w[i] >= size[i]) return nullptr;
+	}
+	//the lines are stored whole, back to back
+	p = getring(p, end, dline, bfsize, 0, bfsize, apply);
+	if (p && apply)
+	{
+		for (int i = 0; i < maxlines; i++)
+		{
+			wIndex[i] = w[i];
+			lpfmem[i] = mem[i];
+			lineout[i] = o[i];
+		}
+	}
+	return p;
+}
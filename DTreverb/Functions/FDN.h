@@ -0,0 +1,50 @@
+#ifndef FDN_h
+#define FDN_h
+#include <stdio.h>
+#include <string.h>
+
+//feedback delay network: 4, 8 or 16 delay lines, each damped by a TLowpassFilter style one pole
+//and scaled for its length, mixed by a Hadamard (fast Walsh-Hadamard transform) or Householder matrix
+class FDN {
+public:
+	static const int maxlines = 16;
+	enum { hadamard, householder };
+
+	FDN();
+	~FDN();
+	void reset();
+	void Buffersize(double sampleRate);
+	void audioprocessing(double inL, double inR, double& outL, double& outR);
+	void setlines(int a);             //4, 8 or 16
+	void setmatrix(int a);            //hadamard or householder
+	void setdecayparams(double a);    //same meaning as the Dattorro decay factor
+	void setdecayparams(double a, const double* cooked);  //per line feedback from decaycoefficients( )
+	void setgainparams(double a);     //damping, TLowpassFilter gain form: 1 = no damping
+	void setfreeze(bool a);
+	void tapout(double* out, int n);   //line outputs of the last sample, for the surround tap matrix
+	static double meanlength(int n);   //average of the first n line lengths at the topology rate
+	static void decaycoefficients(double sampleRate, double a, double* feedback);  //maxlines values
+	int statesize();
+	char* savestate(char* p);
+	const char* loadstate(const char* p, const char* end, bool apply);
+
+	int lines;
+	int matrix;
+	double decay;
+	double gain;
+	bool frozen;
+
+private:
+	double* dline;              //all lines back to back
+	int size[maxlines];         //ring length = delay
+	int offset[maxlines];
+	int wIndex[maxlines];
+	int bfsize;
+	double fs;
+	double feedback[maxlines];  //per line decay, longer lines lose more per pass
+	double lpfmem[maxlines];
+	double lineout[maxlines];
+	double x[maxlines];         //transform work buffer
+};
+
+#endif
@@ -0,0 +1,86 @@
+#define _USE_MATH_DEFINES
+#include "FFT.h"
+#include "DTMath.h"
+#include <cmath>
+
+FFT::FFT()
+{
+	size = 0;
+}
+
+void FFT::setsize(int n)
+{
+	if (n == size) return;
+	size = n;
+
+	int bits = 0;
+	while ((1 << bits) < n) bits++;
+	bitrev.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		int r = 0;
+		for (int b = 0; b < bits; b++)
+			if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+		bitrev[i] = r;
+	}
+
+	costable.resize(n / 2);
+	sintable.resize(n / 2);
+	for (int k = 0; k < n / 2; k++)
+	{
+		costable[k] = dtcos(2 * M_PI * k / n);
+		sintable[k] = dtsin(2 * M_PI * k / n);
+	}
+}
+
+void FFT::forward(double* re, double* im)
+{
+	transform(re, im, -1.0);
+}
+
+void FFT::inverse(double* re, double* im)
+{
+	transform(re, im, 1.0);
+	double scale = 1.0 / size;
+	for (int i = 0; i < size; i++)
+	{
+		re[i] *= scale;
+		im[i] *= scale;
+	}
+}
+
+void FFT::transform(double* re, double* im, double sign)
+{
+	for (int i = 0; i < size; i++)
+	{
+		int j = bitrev[i];
+		if (j > i)
+		{
+			double t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+
+	//iterative decimation in time, butterflies of growing span
+	for (int span = 2; span <= size; span <<= 1)
+	{
+		int half = span / 2;
+		int step = size / span;
+		for (int i = 0; i < size; i += span)
+		{
+			for (int k = 0; k < half; k++)
+			{
+				double wr = costable[k * step];
+				double wi = sign * sintable[k * step];
+				int a = i + k;
+				int b = a + half;
+				double tr = re[b] * wr - im[b] * wi;
+				double ti = re[b] * wi + im[b] * wr;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+		}
+	}
+}
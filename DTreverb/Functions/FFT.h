@@ -0,0 +1,23 @@
+#ifndef FFT_h
+#define FFT_h
+#include <vector>
+
+//radix-2 complex FFT on split real/imaginary arrays; tables are built once in setsize
+class FFT {
+public:
+	FFT();
+	void setsize(int n);                      //power of two, allocates
+	void forward(double* re, double* im);
+	void inverse(double* re, double* im);     //scaled by 1/n, so inverse(forward(x)) == x
+
+	int size;
+
+private:
+	void transform(double* re, double* im, double sign);
+
+	std::vector<int> bitrev;
+	std::vector<double> costable;
+	std::vector<double> sintable;
+};
+
+#endif
@@ -0,0 +1,109 @@
+#define _USE_MATH_DEFINES
+#include "HalfBand.h"
+#include "DTMath.h"
+#include "State.h"
+#include "Simd.h"
+#include <cmath>
+
+HalfBand::HalfBand()
+{
+	//windowed sinc with a Blackman window, cut at a quarter of the higher rate. Only the taps an odd
+	//distance from the centre are nonzero; they are scaled so the branch sums to 1/2 like the centre tap
+	const int taps = 2 * branch - 1;
+	const int centre = taps / 2;
+	double h[branch];
+	double sum = 0.0;
+	for (int l = 0; l < branch; l++)
+	{
+		int n = 2 * l;   //the nonzero taps sit at even indices, the centre at an odd one
+		double x = (n - centre) * 0.5;
+		double w = 0.42 - 0.5 * dtcos(2 * M_PI * (n + 1) / (taps + 1)) + 0.08 * dtcos(4 * M_PI * (n + 1) / (taps + 1));
+		h[l] = dtsin(M_PI * x) / (M_PI * x) * 0.5 * w;
+		sum += h[l];
+	}
+	for (int l = 0; l < branch; l++)
+	{
+		h[l] *= 0.5 / sum;
+		upcoef[branch - 1 - l] = 2 * h[l];   //zero stuffing halves the level
+		downcoef[branch - 1 - l] = h[l];
+	}
+	reset();
+}
+
+void HalfBand::reset()
+{
+	memset(uphist, 0, sizeof(uphist));
+	memset(downhist, 0, sizeof(downhist));
+	memset(odd, 0, sizeof(odd));
+	uppos = downpos = oddpos = 0;
+}
+
+static inline double dot(const double* a, const double* b)
+{
+	dpair acc0 = pairset1(0.0);
+	dpair acc1 = pairset1(0.0);
+	for (int j = 0; j < HalfBand::branch; j += 4)
+	{
+		acc0 = pairadd(acc0, pairmul(pairload(a + j), pairload(b + j)));
+		acc1 = pairadd(acc1, pairmul(pairload(a + j + 2), pairload(b + j + 2)));
+	}
+	return pairsum(pairadd(acc0, acc1));
+}
+
+void HalfBand::upsample(double input, double* output)
+{
+	uphist[uppos] = uphist[uppos + branch] = input;
+	const double* window = uphist + uppos + 1;   //oldest to newest
+	output[0] = dot(upcoef, window);
+	output[1] = window[branch / 2];              //centre tap, branch - 1 samples at the higher rate behind
+	if (++uppos == branch) uppos = 0;
+}
+
+double HalfBand::downsample(const double* input)
+{
+	downhist[downpos] = downhist[downpos + branch] = input[0];
+	double centre = odd[oddpos];
+	odd[oddpos] = input[1];
+	if (++oddpos == branch / 2) oddpos = 0;
+	double out = dot(downcoef, downhist + downpos + 1) + 0.5 * centre;
+	if (++downpos == branch) downpos = 0;
+	return out;
+}
+
+int HalfBand::statesize()
+{
+	return 3 * sizeof(int) + (4 * branch + branch / 2) * sizeof(double);
+}
+
+char* HalfBand::savestate(char* p)
+{
+	p = putstate(p, uppos);
+	p = putstate(p, downpos);
+	p = putstate(p, oddpos);
+	p = putstate(p, uphist);
+	p = putstate(p, downhist);
+	return putstate(p, odd);
+}
+
+const char* HalfBand::loadstate(const char* p, const char* end, bool apply)
+{
+	int up, down, o;
+	double uh[2 * branch], dh[2 * branch], od[branch / 2];
+	p = getstate(p, end, up);
+	p = getstate(p, end, down);
+	p = getstate(p, end, o);
+	p = getstate(p, end, uh);
+	p = getstate(p, end, dh);
+	p = getstate(p, end, od);
+	if (!p || up < 0 || up >= branch || down < 0 || down >= branch || o < 0 || o >= branch / 2) return nullptr;
+	if (apply)
+	{
+		uppos = up;
+		downpos = down;
+		oddpos = o;
+		memcpy(uphist, uh, sizeof(uphist));
+		memcpy(downhist, dh, sizeof(downhist));
+		memcpy(odd, od, sizeof(odd));
+	}
+	return p;
+}
@@ -0,0 +1,33 @@
+#ifndef HalfBand_h
+#define HalfBand_h
+#include <stdio.h>
+#include <string.h>
+
+//one 2x stage of polyphase half-band FIR interpolation and decimation. Every other tap of a half-band
+//filter is zero, so each direction is one 16-tap branch plus a pure delay for the centre tap; the
+//branch runs as 2-wide multiply-adds over a mirrored history that is always contiguous
+class HalfBand {
+public:
+	HalfBand();
+	void reset();
+	void upsample(double input, double* output);   //two output samples at twice the rate
+	double downsample(const double* input);        //two input samples at twice the rate
+	int statesize();
+	char* savestate(char* p);
+	const char* loadstate(const char* p, const char* end, bool apply);
+
+	static const int branch = 16;
+	static const int latency = branch - 1;   //each direction, in samples at the higher rate
+
+private:
+	double upcoef[branch];       //oldest sample first
+	double downcoef[branch];
+	double uphist[2 * branch];   //every sample written twice, branch apart
+	double downhist[2 * branch];
+	double odd[branch / 2];      //odd input samples waiting for the centre tap
+	int uppos;
+	int downpos;
+	int oddpos;
+};
+
+#endif
@@ -1,5 +1,7 @@
 #define _USE_MATH_DEFINES
 #include "LPF.h"
+#include "DTMath.h"
+#include "State.h"
 #include <cmath>
 //comment for the basic strucutre of methods are cited in the Delayline.cpp
 LowpassFilter::LowpassFilter()
@@ -8,7 +10,7 @@ LowpassFilter::LowpassFilter()
 	rIndex = wIndex = 0;
 	dline = new double[bfsize];
 	cutoff = 200;
-	gain = 0.9;
+	gain = dtexp(-2 * M_PI * (cutoff / bfsize));
 	reset();
 
 }
@@ -25,14 +27,23 @@ void LowpassFilter::reset()
 }
 void LowpassFilter::Buffersize(double samplingRate)
 {
+	if (bfsize == (int)samplingRate) { reset(); return; }
 	delete[] dline;
 	bfsize = samplingRate;
 	dline = new double[bfsize];
+	gain = dtexp(-2 * M_PI * (cutoff / bfsize));
 	reset();
 }
 void LowpassFilter::setcutoffparams(const double a) {
 
 	cutoff = a;
+	gain = dtexp(-2 * M_PI * (cutoff / bfsize)); //cooked here, bfsize is the sample rate
+
+}
+void LowpassFilter::setcutoffparams(const double a, const double g) {
+
+	cutoff = a;
+	gain = g;
 
 }
 
@@ -41,13 +52,47 @@ double LowpassFilter::getcutoffparams() {
 	return(cutoff);
 
 }
+int LowpassFilter::statesize()
+{
+	return 2 * sizeof(int) + 3 * sizeof(double) + sizeof(double); //one sample of history
+}
+
+char* LowpassFilter::savestate(char* p)
+{
+	p = putstate(p, bfsize);
+	p = putstate(p, wIndex);
+	p = putstate(p, cutoff);
+	p = putstate(p, gain);
+	p = putstate(p, out);
+	return putring(p, dline, bfsize, wIndex, 1);
+}
+
+const char* LowpassFilter::loadstate(const char* p, const char* end, bool apply)
+{
+	int size, w;
+	double c, g, o;
+	p = getstate(p, end, size);
+	p = getstate(p, end, w);
+	p = getstate(p, end, c);
+	p = getstate(p, end, g);
+	p = getstate(p, end, o);
+	if (!p || size != bfsize) return nullptr;
+	p = getring(p, end, dline, bfsize, w, 1, apply);
+	if (p && apply)
+	{
+		wIndex = w;
+		cutoff = c;
+		gain = g;
+		out = o;
+	}
+	return p;
+}
+
 double LowpassFilter::audioprocessing(double input)
 {
 	rIndex = wIndex - 1; //one sample behind
 	if (rIndex < 0) rIndex += bfsize;
 
-	gain = exp(-2 * M_PI * (cutoff / bfsize));
-	
 	out = input * (1-gain) + dline[rIndex] * gain;
 	dline[wIndex] = out;
 
@@ -12,7 +12,11 @@ public:
 	double lpfout(void);
 	void Buffersize(double sampleRate);
 	void setcutoffparams(const double a);
+	void setcutoffparams(const double a, const double g);  //g cooked by the caller for this cutoff and rate
 	double getcutoffparams();
+	int statesize();
+	char* savestate(char* p);
+	const char* loadstate(const char* p, const char* end, bool apply);
 
 	int bfsize;
 	double out;
@@ -0,0 +1,84 @@
+#include "LevelMeter.h"
+#include "Simd.h"
+#include <cmath>
+
+LevelMeter::LevelMeter() : queue(queuesize)
+{
+	dropped = 0;
+	reset();
+	clearhistory();
+}
+
+void LevelMeter::reset()
+{
+	n = 0;
+	for (int c = 0; c < MeterFrame::channels; c++) held[c] = 0.0f;
+}
+
+//one pass per stereo pair: |x| max and x*x sum two lanes at a time
+void LevelMeter::flush()
+{
+	MeterFrame frame;
+	for (int c = 0; c < MeterFrame::channels; c += 2)
+	{
+		dpair peak = pairset1(0.0);
+		dpair sum = pairset1(0.0);
+		for (int i = 0; i < block; i++)
+		{
+			dpair x = pairload(frames + i * MeterFrame::channels + c);
+			peak = pairmax(peak, pairabs(x));
+			sum = pairadd(sum, pairmul(x, x));
+		}
+		frame.peak[c] = (float)pairlo(peak);
+		frame.peak[c + 1] = (float)pairhi(peak);
+		frame.rms[c] = (float)sqrt(pairlo(sum) / block);
+		frame.rms[c + 1] = (float)sqrt(pairhi(sum) / block);
+	}
+	n = 0;
+
+	for (int c = 0; c < MeterFrame::channels; c++)
+		if (frame.peak[c] > held[c]) held[c] = frame.peak[c];
+	if (!queue.try_enqueue(frame)) dropped++;   //never allocates
+}
+
+void LevelMeter::takepeak(float* out)
+{
+	for (int c = 0; c < MeterFrame::channels; c++)
+	{
+		out[c] = held[c];
+		held[c] = 0.0f;
+	}
+}
+
+int LevelMeter::drain()
+{
+	int count = 0;
+	MeterFrame frame;
+	while (queue.try_dequeue(frame))
+	{
+		history[hpos] = frame;
+		if (++hpos == historysize) hpos = 0;
+		if (hfill < historysize) hfill++;
+		count++;
+	}
+	return count;
+}
+
+int LevelMeter::gethistory(MeterFrame* out, int count)
+{
+	if (count > hfill) count = hfill;
+	int r = hpos - count;
+	if (r < 0) r += historysize;
+	for (int i = 0; i < count; i++)
+	{
+		out[i] = history[r];
+		if (++r == historysize) r = 0;
+	}
+	return count;
+}
+
+void LevelMeter::clearhistory()
+{
+	hpos = 0;
+	hfill = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef LevelMeter_h
+#define LevelMeter_h
+#include <stdio.h>
+#include <string.h>
+#include "readerwriterqueue.h"
+
+//peak and RMS of one block of frames; channels are input L/R, wet L/R, tank L/R
+struct MeterFrame {
+	enum { channels = 6 };
+	float peak[channels];
+	float rms[channels];
+};
+
+//block metering for the input, the wet output and the tank feedback. The audio thread only stores
+//samples into a plain block buffer; every full block is reduced two channels at a time and handed to
+//the GUI through a preallocated single producer, single consumer queue, so there is one queue push
+//per block and nothing shared per sample. The GUI timer drains the queue into a history ring that
+//keeps every block
+class LevelMeter {
+public:
+	LevelMeter();
+	void reset();     //audio thread: drops a half-filled block
+	inline void audioprocessing(double inL, double inR, double wetL, double wetR, double tankL, double tankR)
+	{
+		double* p = frames + n * MeterFrame::channels;
+		p[0] = inL; p[1] = inR;
+		p[2] = wetL; p[3] = wetR;
+		p[4] = tankL; p[5] = tankR;
+		if (++n == block) flush();
+	}
+	void takepeak(float* out);   //audio thread: highest block peaks since the last call, for the meter parameters
+
+	//GUI thread
+	int drain();                                 //moves the queued blocks into the history, returns how many
+	int gethistory(MeterFrame* out, int count);  //newest count blocks, oldest first
+	void clearhistory();
+
+	enum { block = 64, queuesize = 4096, historysize = 4096 };
+
+	int dropped;   //blocks the queue had no room for, GUI closed or late
+
+private:
+	void flush();
+
+	double frames[block * MeterFrame::channels];
+	int n;
+	float held[MeterFrame::channels];
+	moodycamel::ReaderWriterQueue<MeterFrame> queue;
+
+	MeterFrame history[historysize];
+	int hpos;
+	int hfill;
+};
+
+#endif
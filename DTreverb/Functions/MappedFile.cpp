@@ -0,0 +1,102 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	data = nullptr;
+	size = 0;
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mapHandle = nullptr;
+#else
+	fd = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const char* path)
+{
+	close();
+#ifdef _WIN32
+	fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) { close(); return false; }
+	size = (uint64_t)fileSize.QuadPart;
+	mapHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapHandle) { close(); return false; }
+	data = (const uint8_t*)MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+	fd = ::open(path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) { close(); return false; }
+	size = (uint64_t)st.st_size;
+	void* p = mmap(nullptr, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+	data = (p == MAP_FAILED) ? nullptr : (const uint8_t*)p;
+#endif
+	if (!data) { close(); return false; }
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (data) UnmapViewOfFile(data);
+	if (mapHandle) CloseHandle(mapHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+	mapHandle = nullptr;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (data) munmap((void*)data, (size_t)size);
+	if (fd >= 0) ::close(fd);
+	fd = -1;
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+void MappedFile::sequential()
+{
+#ifndef _WIN32
+	if (data) posix_madvise((void*)data, (size_t)size, POSIX_MADV_SEQUENTIAL);
+#endif
+}
+
+void MappedFile::release(uint64_t offset, uint64_t length)
+{
+	if (!data || offset >= size) return;
+
+	//only whole pages inside the range are dropped
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	uint64_t page = (uint64_t)info.dwPageSize;
+#else
+	uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+	uint64_t start = (offset + page - 1) / page * page;
+	uint64_t end = (offset + length) / page * page;
+	if (end > size) end = size / page * page;
+	if (end <= start) return;
+
+#ifdef _WIN32
+	//unlocking pages that were never locked removes them from the working set; it reports ERROR_NOT_LOCKED, which is expected
+	VirtualUnlock((void*)(data + start), (SIZE_T)(end - start));
+#else
+	//posix_madvise(POSIX_MADV_DONTNEED) is only a hint and glibc ignores it, madvise really unmaps the pages
+	madvise((void*)(data + start), (size_t)(end - start), MADV_DONTNEED);
+#endif
+}
@@ -0,0 +1,29 @@
+#ifndef MappedFile_h
+#define MappedFile_h
+#include <stdio.h>
+#include <stdint.h>
+
+//read-only memory map of a whole file; pages are faulted in by the OS, so large files cost address space, not RAM
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char* path);
+	void close();
+	void sequential();                            //hint that the file is read front to back
+	void release(uint64_t offset, uint64_t length); //unmap consumed pages from the process, they fault back in from the file if touched again
+
+	const uint8_t* data;
+	uint64_t size;
+
+private:
+#ifdef _WIN32
+	void* fileHandle;
+	void* mapHandle;
+#else
+	int fd;
+#endif
+};
+
+#endif
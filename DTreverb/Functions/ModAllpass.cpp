@@ -0,0 +1,150 @@
+#include "ModAllpass.h"
+#include "DTMath.h"
+#include "State.h"
+#include <cmath>
+
+ModAllpass::ModAllpass()
+{
+	ring = nullptr;
+	fs = 0;
+	gain = 0.5;
+	factor = 1;
+	delay = 1;
+	excursion = 0;
+	Buffersize(48000, 1, 0);
+}
+
+ModAllpass::~ModAllpass()
+{
+	delete[] ring;
+}
+
+void ModAllpass::reset()
+{
+	wIndex = 0;
+	memset(ring, 0, (mask + 1) * sizeof(double));
+	stage[0].reset();
+	stage[1].reset();
+	pad[0] = pad[1] = 0.0;
+}
+
+void ModAllpass::Buffersize(double sampleRate, int _delay, int _excursion)
+{
+	int size = 1;
+	while (size < 4 * (_delay + _excursion) + 2) size *= 2;
+	if (!ring || size != mask + 1)
+	{
+		delete[] ring;
+		ring = new double[size];
+		mask = size - 1;
+	}
+	delay = _delay;
+	excursion = _excursion;
+	fs = sampleRate;
+	reset();
+}
+
+void ModAllpass::setgainparams(const double a)
+{
+	gain = a;
+}
+
+void ModAllpass::setfactor(int a)
+{
+	if (a != 1 && a != 2 && a != 4) a = 1;
+	if (a == factor) return;
+	factor = a;
+	reset();
+}
+
+int ModAllpass::latency()
+{
+	//up and down through each stage, at 4x with the pad
+	return factor == 4 ? (3 * HalfBand::latency + 1) / 2 : factor == 2 ? HalfBand::latency : 0;
+}
+
+inline double ModAllpass::section(double input, double mod)
+{
+	double pos = factor * (delay + mod * excursion);
+	int i = (int)pos;
+	double frac = pos - i;
+	double d_out = ring[(wIndex - i) & mask];
+	if (frac != 0.0) d_out += (ring[(wIndex - i - 1) & mask] - d_out) * frac;
+	double d_in = input + d_out * gain;
+	ring[wIndex] = d_in;
+	wIndex = (wIndex + 1) & mask;
+	return d_in * -gain + d_out;
+}
+
+double ModAllpass::audioprocessing(double input, double mod)
+{
+	if (factor == 1)
+		return section(input, mod);
+
+	double up[2], out[2];
+	stage[0].upsample(input, up);
+	if (factor == 2)
+	{
+		out[0] = section(up[0], mod);
+		out[1] = section(up[1], mod);
+	}
+	else
+	{
+		for (int j = 0; j < 2; j++)
+		{
+			double up4[2], out4[2];
+			stage[1].upsample(up[j], up4);
+			out4[0] = section(pad[0], mod);
+			out4[1] = section(pad[1], mod);
+			pad[0] = up4[0];
+			pad[1] = up4[1];
+			out[j] = stage[1].downsample(out4);
+		}
+	}
+	return stage[0].downsample(out);
+}
+
+int ModAllpass::history()
+{
+	return factor * (delay + excursion) + 2;
+}
+
+int ModAllpass::statesize()
+{
+	return 3 * sizeof(int) + (history() + 2) * sizeof(double) + stage[0].statesize() + stage[1].statesize();
+}
+
+char* ModAllpass::savestate(char* p)
+{
+	p = putstate(p, mask);
+	p = putstate(p, factor);
+	p = putstate(p, wIndex);
+	p = putring(p, ring, mask + 1, wIndex, history());
+	p = putstate(p, pad);
+	p = stage[0].savestate(p);
+	return stage[1].savestate(p);
+}
+
+const char* ModAllpass::loadstate(const char* p, const char* end, bool apply)
+{
+	//the half-band stages are checked before the first change
+	if (apply && !loadstate(p, end, false)) return nullptr;
+
+	int size, f, w;
+	double pd[2];
+	p = getstate(p, end, size);
+	p = getstate(p, end, f);
+	p = getstate(p, end, w);
+	if (!p || size != mask || (f != 1 && f != 2 && f != 4)) return nullptr;
+	p = getring(p, end, ring, mask + 1, w, f * (delay + excursion) + 2, apply);
+	p = getstate(p, end, pd);
+	p = stage[0].loadstate(p, end, apply);
+	p = stage[1].loadstate(p, end, apply);
+	if (p && apply)
+	{
+		factor = f;
+		wIndex = w;
+		memcpy(pad, pd, sizeof(pad));
+	}
+	return p;
+}
@@ -0,0 +1,41 @@
+#ifndef ModAllpass_h
+#define ModAllpass_h
+#include <stdio.h>
+#include <string.h>
+#include "HalfBand.h"
+
+//modulated allpass for the input of each tank half, MAllp sign convention. The delay is read with linear
+//interpolation; at 2x or 4x the allpass runs between half-band interpolation and decimation stages, so
+//the interpolation error and the images of the moving delay stay above the audio band
+class ModAllpass {
+public:
+	ModAllpass();
+	~ModAllpass();
+	void reset();
+	void Buffersize(double sampleRate, int _delay, int _excursion);  //samples at the base rate; allocates for 4x
+	void setgainparams(const double a);
+	void setfactor(int a);                 //1, 2 or 4; clears the allpass, its old samples are at another rate
+	double audioprocessing(double input, double mod);   //mod -1..1 of the excursion
+	int latency();                         //base rate samples the half-band stages add
+	int statesize();
+	char* savestate(char* p);
+	const char* loadstate(const char* p, const char* end, bool apply);
+
+	double gain;
+	int factor;
+
+private:
+	double section(double input, double mod);
+	int history();
+
+	double* ring;       //power of two, long enough for 4x
+	int mask;
+	int wIndex;
+	int delay;
+	int excursion;
+	double fs;
+	HalfBand stage[2];  //fs to 2fs, 2fs to 4fs
+	double pad[2];      //4x: the previous pair, two samples that make the stage latency a whole base sample
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "PresetBank.h"
+#include <string.h>
+
+static const char kBankMagic[4] = { 'D', 'T', 'p', 'b' };
+const uint32_t PresetBank::version;
+
+//sections start on 8 bytes so the doubles can be read straight out of the map
+static uint64_t align8(uint64_t size) { return (size + 7) & ~(uint64_t)7; }
+
+PresetBank::PresetBank()
+{
+	entries = nullptr;
+	values = nullptr;
+	controlIDs = nullptr;
+	names = nullptr;
+	presets = pairs = namebytes = 0;
+}
+
+bool PresetBank::open(const char* path)
+{
+	close();
+	if (!map.open(path) || map.size < sizeof(PresetBankHeader)) { close(); return false; }
+
+	const PresetBankHeader* header = (const PresetBankHeader*)map.data;
+	if (memcmp(header->magic, kBankMagic, 4) != 0 || header->version != version) { close(); return false; }
+
+	uint64_t entryOffset = sizeof(PresetBankHeader);
+	uint64_t valueOffset = align8(entryOffset + (uint64_t)header->presets * sizeof(PresetBankEntry));
+	uint64_t idOffset = valueOffset + (uint64_t)header->pairs * sizeof(double);
+	uint64_t nameOffset = align8(idOffset + (uint64_t)header->pairs * sizeof(uint32_t));
+	if (nameOffset + header->namebytes != map.size) { close(); return false; }
+
+	presets = header->presets;
+	pairs = header->pairs;
+	namebytes = header->namebytes;
+	entries = (const PresetBankEntry*)(map.data + entryOffset);
+	values = (const double*)(map.data + valueOffset);
+	controlIDs = (const uint32_t*)(map.data + idOffset);
+	names = (const char*)(map.data + nameOffset);
+	return true;
+}
+
+void PresetBank::close()
+{
+	map.close();
+	entries = nullptr;
+	values = nullptr;
+	controlIDs = nullptr;
+	names = nullptr;
+	presets = pairs = namebytes = 0;
+}
+
+const char* PresetBank::name(uint32_t index)
+{
+	if (index >= presets) return nullptr;
+	const PresetBankEntry& entry = entries[index];
+	if ((uint64_t)entry.name + entry.namelength >= namebytes || names[entry.name + entry.namelength] != 0) return nullptr;
+	return names + entry.name;
+}
+
+uint32_t PresetBank::parameters(uint32_t index, const uint32_t*& ids, const double*& vals)
+{
+	if (index >= presets) return 0;
+	const PresetBankEntry& entry = entries[index];
+	if ((uint64_t)entry.first + entry.count > pairs) return 0;
+	ids = controlIDs + entry.first;
+	vals = values + entry.first;
+	return entry.count;
+}
+
+void PresetBankWriter::addpreset(const char* name)
+{
+	PresetBankEntry entry;
+	entry.first = (uint32_t)values.size();
+	entry.count = 0;
+	entry.name = (uint32_t)names.size();
+	entry.namelength = (uint32_t)strlen(name);
+	entries.push_back(entry);
+	names.append(name);
+	names.push_back('\0');
+}
+
+void PresetBankWriter::addparameter(uint32_t controlID, double value)
+{
+	if (entries.empty()) return;
+	controlIDs.push_back(controlID);
+	values.push_back(value);
+	entries.back().count++;
+}
+
+bool PresetBankWriter::write(const char* path)
+{
+	FILE* file = fopen(path, "wb");
+	if (!file) return false;
+
+	PresetBankHeader header = {};
+	memcpy(header.magic, kBankMagic, 4);
+	header.version = PresetBank::version;
+	header.presets = (uint32_t)entries.size();
+	header.pairs = (uint32_t)values.size();
+	header.namebytes = (uint32_t)names.size();
+
+	static const char zeros[8] = { 0 };
+	uint64_t entryEnd = sizeof(header) + entries.size() * sizeof(PresetBankEntry);
+	uint64_t idEnd = align8(entryEnd) + values.size() * sizeof(double) + controlIDs.size() * sizeof(uint32_t);
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok &= fwrite(entries.data(), sizeof(PresetBankEntry), entries.size(), file) == entries.size();
+	ok &= fwrite(zeros, 1, (size_t)(align8(entryEnd) - entryEnd), file) == align8(entryEnd) - entryEnd;
+	ok &= fwrite(values.data(), sizeof(double), values.size(), file) == values.size();
+	ok &= fwrite(controlIDs.data(), sizeof(uint32_t), controlIDs.size(), file) == controlIDs.size();
+	ok &= fwrite(zeros, 1, (size_t)(align8(idEnd) - idEnd), file) == align8(idEnd) - idEnd;
+	ok &= fwrite(names.data(), 1, names.size(), file) == names.size();
+	ok &= fclose(file) == 0;
+	return ok;
+}
@@ -0,0 +1,76 @@
+#ifndef PresetBank_h
+#define PresetBank_h
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+//binary preset bank, little-endian, every section 8-byte aligned:
+//header | entries[presets] | values[pairs] (double) | controlIDs[pairs] (uint32) | names (0 terminated)
+struct PresetBankHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t presets;
+	uint32_t pairs;
+	uint32_t namebytes;
+	uint32_t reserved;
+};
+
+struct PresetBankEntry {
+	uint32_t first;     //index of the first controlID/value pair
+	uint32_t count;
+	uint32_t name;      //offset into the name block
+	uint32_t namelength;
+};
+
+//a bank read in place from a memory map: open checks the header and the section sizes only, each
+//preset is bounds checked when it is touched, so opening costs the same for ten presets or ten thousand
+class PresetBank {
+public:
+	PresetBank();
+
+	bool open(const char* path);
+	void close();
+	bool isopen() { return entries != nullptr; }
+
+	uint32_t count() { return presets; }
+	const char* name(uint32_t index);   //nullptr when out of range or damaged
+	uint32_t parameters(uint32_t index, const uint32_t*& controlIDs, const double*& values);  //pairs of one preset, 0 when out of range
+
+	static const uint32_t version = 1;
+
+private:
+	MappedFile map;
+	const PresetBankEntry* entries;
+	const double* values;
+	const uint32_t* controlIDs;
+	const char* names;
+	uint32_t presets;
+	uint32_t pairs;
+	uint32_t namebytes;
+};
+
+//collects presets one parameter at a time and writes them as a bank
+class PresetBankWriter {
+public:
+	void addpreset(const char* name);
+	void addparameter(uint32_t controlID, double value);  //belongs to the last preset added
+	bool write(const char* path);
+
+private:
+	std::vector<PresetBankEntry> entries;
+	std::vector<double> values;
+	std::vector<uint32_t> controlIDs;
+	std::string names;
+};
+
+//what the core and the preset browser view exchange on each GUI timer ping; GUI thread only
+struct PresetBrowse {
+	std::vector<std::string> names;   //core to view: the presets of the mapped bank, valid when namesChanged
+	bool namesChanged = false;
+	int32_t selected = -1;            //view to core: preset picked since the last ping, -1 = none
+	std::string loadPath;             //view to core: bank file picked since the last ping, empty = none
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "Profile.h"
+
+#ifdef DTREVERB_PROFILE
+#include <stdio.h>
+
+StageProfile::StageProfile()
+{
+	for (int s = 0; s < prof_stages; s++)
+	{
+		pending[s] = 0;
+		for (int b = 0; b < bins; b++) histogram[s][b].store(0, std::memory_order_relaxed);
+		ticks[s].store(0, std::memory_order_relaxed);
+	}
+	clearRequest.store(false, std::memory_order_relaxed);
+}
+
+//single writer: plain load and store instead of a locked read-modify-write
+void StageProfile::commit()
+{
+	if (clearRequest.load(std::memory_order_relaxed))
+	{
+		for (int s = 0; s < prof_stages; s++)
+		{
+			for (int b = 0; b < bins; b++) histogram[s][b].store(0, std::memory_order_relaxed);
+			ticks[s].store(0, std::memory_order_relaxed);
+		}
+		clearRequest.store(false, std::memory_order_relaxed);
+	}
+
+	for (int s = 0; s < prof_stages; s++)
+	{
+		uint64_t t = pending[s];
+		if (t == 0) continue;   //stage did not run this sample
+		pending[s] = 0;
+		int b = 0;
+		while (b < bins - 1 && (t >> (b + 1)) != 0) b++;
+		histogram[s][b].store(histogram[s][b].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		ticks[s].store(ticks[s].load(std::memory_order_relaxed) + t, std::memory_order_relaxed);
+	}
+}
+
+void StageProfile::clear()
+{
+	clearRequest.store(true, std::memory_order_relaxed);
+}
+
+const char* StageProfile::name(int stage)
+{
+	static const char* names[prof_stages] = { "input diffuser", "modulated allpass", "tank delays", "damping", "output taps" };
+	return stage >= 0 && stage < prof_stages ? names[stage] : "";
+}
+
+//percentiles are the upper edge of the bin they fall in; the counters are read one by one, so a
+//report taken while audio runs can be a sample or so out of step between columns
+std::string StageProfile::report() const
+{
+#ifdef DT_RDTSC
+	const char* unit = "cycles";
+#else
+	const char* unit = "ns";
+#endif
+	std::string out;
+	char line[160];
+	snprintf(line, sizeof(line), "%-18s %12s %10s %10s %10s %10s  (%s per sample)\n", "stage", "samples", "mean", "p50", "p99", "max", unit);
+	out += line;
+
+	for (int s = 0; s < prof_stages; s++)
+	{
+		uint64_t hist[bins];
+		uint64_t count = 0;
+		for (int b = 0; b < bins; b++)
+		{
+			hist[b] = histogram[s][b].load(std::memory_order_relaxed);
+			count += hist[b];
+		}
+		uint64_t total = ticks[s].load(std::memory_order_relaxed);
+
+		uint64_t p50 = 0, p99 = 0, top = 0, seen = 0;
+		for (int b = 0; b < bins; b++)
+		{
+			if (hist[b] == 0) continue;
+			uint64_t edge = ((uint64_t)2 << b) - 1;
+			seen += hist[b];
+			if (p50 == 0 && seen * 2 >= count) p50 = edge;
+			if (p99 == 0 && seen * 100 >= count * 99) p99 = edge;
+			top = edge;
+		}
+		snprintf(line, sizeof(line), "%-18s %12llu %10.1f %10llu %10llu %10llu\n", name(s), (unsigned long long)count,
+			count > 0 ? (double)total / count : 0.0, (unsigned long long)p50, (unsigned long long)p99, (unsigned long long)top);
+		out += line;
+	}
+	return out;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef Profile_h
+#define Profile_h
+
+//per-stage cycle histograms for one plugin instance, only built with DTREVERB_PROFILE defined.
+//The audio thread is the only writer: it sums the ticks each stage takes within a sample and
+//files the sums into log2 bins once per sample with relaxed atomic stores, so any other thread
+//can read a report without a lock and without ever stalling the audio thread. Without the define
+//the macros below are empty and nothing of this is compiled
+#ifdef DTREVERB_PROFILE
+#include <stdint.h>
+#include <string>
+#include <atomic>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define DT_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define DT_RDTSC 1
+#else
+#include <time.h>
+#endif
+
+enum profileStage { prof_diffuser, prof_modallpass, prof_tankdelays, prof_damping, prof_taps, prof_stages };
+
+class StageProfile {
+public:
+	enum { bins = 40 };        //bin b holds samples that took 2^b to 2^(b+1)-1 ticks
+
+	StageProfile();
+	static inline uint64_t now()   //TSC ticks on x86, nanoseconds elsewhere
+	{
+#ifdef DT_RDTSC
+		return __rdtsc();
+#else
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+	}
+	inline uint64_t lap(int stage, uint64_t since)   //charges the ticks since the last lap to stage
+	{
+		uint64_t t = now();
+		pending[stage] += t - since;
+		return t;
+	}
+	void commit();             //audio thread, once per sample
+	void clear();              //any thread; done by the audio thread at its next commit
+	std::string report() const;   //any thread: samples, mean and percentiles per stage
+	static const char* name(int stage);
+
+private:
+	uint64_t pending[prof_stages];
+	std::atomic<uint64_t> histogram[prof_stages][bins];
+	std::atomic<uint64_t> ticks[prof_stages];
+	std::atomic<bool> clearRequest;
+};
+
+#define DT_PROFILE_START(t) uint64_t t = StageProfile::now()
+#define DT_PROFILE_LAP(profile, stage, t) if (profile) t = (profile)->lap(stage, t)
+#define DT_PROFILE_COMMIT(profile) (profile)->commit()
+
+#else
+
+#define DT_PROFILE_START(t)
+#define DT_PROFILE_LAP(profile, stage, t)
+#define DT_PROFILE_COMMIT(profile)
+
+#endif
+
+#endif
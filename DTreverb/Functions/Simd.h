@@ -0,0 +1,43 @@
+#ifndef Simd_h
+#define Simd_h
+#include "DTMath.h"
+
+//two doubles processed as one: SSE2 where the compiler has it, plain scalar code otherwise.
+//Only add/sub/mul, plus the exact abs/max, are used so results are bit-identical to the scalar objects
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DT_SSE2 1
+
+typedef __m128d dpair;
+inline dpair pairset(double l, double r) { return _mm_set_pd(r, l); }
+inline dpair pairset1(double a) { return _mm_set1_pd(a); }
+inline dpair pairload(const double* p) { return _mm_loadu_pd(p); }
+inline void pairstore(double* p, dpair a) { _mm_storeu_pd(p, a); }
+inline dpair pairadd(dpair a, dpair b) { return _mm_add_pd(a, b); }
+inline dpair pairsub(dpair a, dpair b) { return _mm_sub_pd(a, b); }
+inline dpair pairmul(dpair a, dpair b) { return _mm_mul_pd(a, b); }
+inline double pairlo(dpair a) { return _mm_cvtsd_f64(a); }
+inline double pairhi(dpair a) { return _mm_cvtsd_f64(_mm_unpackhi_pd(a, a)); }
+inline double pairsum(dpair a) { return pairlo(a) + pairhi(a); }
+inline dpair pairabs(dpair a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+inline dpair pairmax(dpair a, dpair b) { return _mm_max_pd(a, b); }
+
+#else
+
+struct dpair { double l, r; };
+inline dpair pairset(double l, double r) { dpair p = { l, r }; return p; }
+inline dpair pairset1(double a) { dpair p = { a, a }; return p; }
+inline dpair pairload(const double* p) { dpair a = { p[0], p[1] }; return a; }
+inline void pairstore(double* p, dpair a) { p[0] = a.l; p[1] = a.r; }
+inline dpair pairadd(dpair a, dpair b) { dpair p = { a.l + b.l, a.r + b.r }; return p; }
+inline dpair pairsub(dpair a, dpair b) { dpair p = { a.l - b.l, a.r - b.r }; return p; }
+inline dpair pairmul(dpair a, dpair b) { dpair p = { a.l * b.l, a.r * b.r }; return p; }
+inline double pairlo(dpair a) { return a.l; }
+inline double pairhi(dpair a) { return a.r; }
+inline double pairsum(dpair a) { return a.l + a.r; }
+inline dpair pairabs(dpair a) { dpair p = { a.l < 0 ? -a.l : a.l, a.r < 0 ? -a.r : a.r }; return p; }
+inline dpair pairmax(dpair a, dpair b) { dpair p = { a.l > b.l ? a.l : b.l, a.r > b.r ? a.r : b.r }; return p; }
+
+#endif
+
+#endif
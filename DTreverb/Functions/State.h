@@ -0,0 +1,47 @@
+#ifndef State_h
+#define State_h
+#include <string.h>
+#include <stddef.h>
+
+//helpers for the savestate/loadstate methods of the delay objects; state is a flat byte blob, native endian
+
+template <class T> inline char* putstate(char* p, const T& value)
+{
+	memcpy(p, &value, sizeof(T));
+	return p + sizeof(T);
+}
+
+//reads are bounds checked: nullptr once the blob runs short, and every later read passes the nullptr on
+template <class T> inline const char* getstate(const char* p, const char* end, T& value)
+{
+	if (!p || end - p < (ptrdiff_t)sizeof(T)) return nullptr;
+	memcpy(&value, p, sizeof(T));
+	return p + sizeof(T);
+}
+
+//only the n samples behind the write pointer can still be read, so that is all that gets stored
+inline char* putring(char* p, const double* ring, int size, int wIndex, int n)
+{
+	int start = wIndex - n;
+	if (start < 0) start += size;
+	int first = (start + n <= size) ? n : size - start; //samples before the wrap
+	memcpy(p, ring + start, first * sizeof(double));
+	memcpy(p + first * sizeof(double), ring, (n - first) * sizeof(double));
+	return p + n * sizeof(double);
+}
+
+//copies straight back into the existing ring, nothing is allocated; the write index and length are
+//checked against the ring first, apply = false only skips over the samples
+inline const char* getring(const char* p, const char* end, double* ring, int size, int wIndex, int n, bool apply)
+{
+	if (!p || wIndex < 0 || wIndex >= size || n < 0 || n > size || end - p < (ptrdiff_t)(n * sizeof(double))) return nullptr;
+	if (!apply) return p + n * sizeof(double);
+	int start = wIndex - n;
+	if (start < 0) start += size;
+	int first = (start + n <= size) ? n : size - start;
+	memcpy(ring + start, p, first * sizeof(double));
+	memcpy(ring, p + first * sizeof(double), (n - first) * sizeof(double));
+	return p + n * sizeof(double);
+}
+
+#endif
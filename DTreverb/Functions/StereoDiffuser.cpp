@@ -0,0 +1,170 @@
+#define _USE_MATH_DEFINES
+#include "StereoDiffuser.h"
+#include "DTMath.h"
+#include "State.h"
+#include "Simd.h"
+#include "Dattorro.h"
+#include <cmath>
+
+StereoDiffuser::StereoDiffuser()
+{
+	dline = nullptr;
+	bfsize = 0;
+	fs = 0;
+	cutoff = 200;
+	gain = 0.5;
+	lpfgain = 0.9;
+	Buffersize(48000);
+}
+
+StereoDiffuser::~StereoDiffuser()
+{
+	delete[] dline;
+}
+
+void StereoDiffuser::reset()
+{
+	for (int i = 0; i < stages; i++) wIndex[i] = 0;
+	lpfmem[0] = lpfmem[1] = 0.0;
+	memset(dline, 0, 2 * bfsize * sizeof(double));
+}
+
+void StereoDiffuser::Buffersize(double sampleRate)
+{
+	if (dline && fs == sampleRate) { reset(); return; }
+
+	int fsConverted = (int)round(sampleRate / DattorroTopology::rate);
+	size[0] = (int)sampleRate;  //predelay, up to one second as in the mono path
+	delay[0] = DattorroTopology::predelay * fsConverted;
+	for (int i = 1; i < stages; i++)
+		size[i] = delay[i] = DattorroTopology::diffuser[i - 1] * fsConverted;  //same allpass lengths as apf1..apf4
+
+	bfsize = 0;
+	for (int i = 0; i < stages; i++)
+	{
+		offset[i] = bfsize;
+		bfsize += size[i];
+	}
+
+	delete[] dline;
+	dline = new double[2 * bfsize];
+	fs = sampleRate;
+	setcutoffparams(cutoff);
+	reset();
+}
+
+void StereoDiffuser::setdelayparams(const int a)
+{
+	delay[0] = a;
+}
+
+void StereoDiffuser::setcutoffparams(const double a)
+{
+	cutoff = a;
+	lpfgain = dtexp(-2 * M_PI * (cutoff / fs));  //same one pole as LowpassFilter, cooked here instead of per sample
+}
+
+void StereoDiffuser::setcutoffparams(const double a, const double g)
+{
+	cutoff = a;
+	lpfgain = g;
+}
+
+void StereoDiffuser::setgainparams(const double a)
+{
+	gain = a;
+}
+
+void StereoDiffuser::audioprocessing(double inL, double inR, double& outL, double& outR)
+{
+	//predelay
+	int r = wIndex[0] - delay[0];
+	if (r < 0) r += size[0];
+	double* ring = dline + 2 * offset[0];
+	dpair x = pairload(ring + 2 * r);
+	pairstore(ring + 2 * wIndex[0], pairset(inL, inR));
+	if (++wIndex[0] >= size[0]) wIndex[0] = 0;
+
+	//bandwidth lowpass
+	dpair g = pairset1(lpfgain);
+	x = pairadd(pairmul(x, pairsub(pairset1(1.0), g)), pairmul(pairload(lpfmem), g));
+	pairstore(lpfmem, x);
+
+	//allpasses; ring length equals the delay so the read position is the write position
+	dpair k = pairset1(gain);
+	for (int i = 1; i < stages; i++)
+	{
+		double* p = dline + 2 * (offset[i] + wIndex[i]);
+		dpair d_out = pairload(p);
+		dpair d_in = pairsub(x, pairmul(d_out, k));
+		x = pairadd(pairmul(d_in, k), d_out);
+		pairstore(p, d_in);
+		if (++wIndex[i] >= size[i]) wIndex[i] = 0;
+	}
+
+	outL = pairlo(x);
+	outR = pairhi(x);
+}
+
+int StereoDiffuser::statesize()
+{
+	int history = (delay[0] > 0 && delay[0] <= size[0]) ? delay[0] : size[0];
+	for (int i = 1; i < stages; i++) history += size[i];
+	return sizeof(int) * (1 + 2 * stages) + 2 * sizeof(double) + 2 * history * sizeof(double);
+}
+
+char* StereoDiffuser::savestate(char* p)
+{
+	p = putstate(p, bfsize);
+	for (int i = 0; i < stages; i++)
+	{
+		p = putstate(p, delay[i]);
+		p = putstate(p, wIndex[i]);
+	}
+	p = putstate(p, lpfmem[0]);
+	p = putstate(p, lpfmem[1]);
+
+	//rings hold interleaved pairs, store them as rings of twice the length
+	int history = (delay[0] > 0 && delay[0] <= size[0]) ? delay[0] : size[0];
+	p = putring(p, dline + 2 * offset[0], 2 * size[0], 2 * wIndex[0], 2 * history);
+	for (int i = 1; i < stages; i++)
+		p = putring(p, dline + 2 * offset[i], 2 * size[i], 2 * wIndex[i], 2 * size[i]);
+	return p;
+}
+
+const char* StereoDiffuser::loadstate(const char* p, const char* end, bool apply)
+{
+	//every ring is checked before the first one is copied
+	if (apply && !loadstate(p, end, false)) return nullptr;
+
+	int total;
+	int d[stages];
+	int w[stages];
+	double mem[2];
+	p = getstate(p, end, total);
+	if (!p || total != bfsize) return nullptr;
+	for (int i = 0; i < stages; i++)
+	{
+		p = getstate(p, end, d[i]);
+		p = getstate(p, end, w[i]);
+		if (!p || d[i] < 0 || d[i] > size[i]) return nullptr;
+	}
+	p = getstate(p, end, mem[0]);
+	p = getstate(p, end, mem[1]);
+
+	int history = d[0] > 0 ? d[0] : size[0];
+	p = getring(p, end, dline + 2 * offset[0], 2 * size[0], 2 * w[0], 2 * history, apply);
+	for (int i = 1; i < stages; i++)
+		p = getring(p, end, dline + 2 * offset[i], 2 * size[i], 2 * w[i], 2 * size[i], apply);
+	if (p && apply)
+	{
+		for (int i = 0; i < stages; i++)
+		{
+			delay[i] = d[i];
+			wIndex[i] = w[i];
+		}
+		lpfmem[0] = mem[0];
+		lpfmem[1] = mem[1];
+	}
+	return p;
+}
@@ -0,0 +1,40 @@
+#ifndef StereoDiffuser_h
+#define StereoDiffuser_h
+#include <stdio.h>
+#include <string.h>
+
+//true stereo input diffuser: predelay, lowpass and the four Dattorro allpasses for left and right.
+//Both chains share delay lengths, so their buffers are interleaved L/R and run as one 2-wide chain
+class StereoDiffuser {
+public:
+	StereoDiffuser();
+	~StereoDiffuser();
+	void reset();
+	void Buffersize(double sampleRate);
+	void audioprocessing(double inL, double inR, double& outL, double& outR);
+	void setdelayparams(const int a);     //predelay in samples
+	void setcutoffparams(const double a);
+	void setcutoffparams(const double a, const double g);  //one pole gain cooked by the caller
+	void setgainparams(const double a);
+	int statesize();
+	char* savestate(char* p);
+	const char* loadstate(const char* p, const char* end, bool apply);
+
+	double cutoff;
+	double gain;
+
+private:
+	static const int stages = 5;  //predelay + four allpasses
+
+	double* dline;           //all five rings back to back, two doubles per sample
+	int size[stages];
+	int offset[stages];
+	int delay[stages];
+	int wIndex[stages];
+	int bfsize;              //total samples per channel
+	double fs;
+	double lpfgain;
+	double lpfmem[2];
+};
+
+#endif
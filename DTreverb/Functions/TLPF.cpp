@@ -1,5 +1,7 @@
 #define _USE_MATH_DEFINES
 #include "TLPF.h"
+#include "DTMath.h"
+#include "State.h"
 #include <cmath>
 //comment for the basic strucutre of methods are cited in the Delayline.cpp
 TLowpassFilter::TLowpassFilter()
@@ -25,6 +27,7 @@ void TLowpassFilter::reset()
 }
 void TLowpassFilter::Buffersize(double samplingRate)
 {
+	if (bfsize == (int)samplingRate) { reset(); return; }
 	delete[] dline;
 	bfsize = samplingRate;
 	dline = new double[bfsize];
@@ -41,6 +44,39 @@ double TLowpassFilter::getgainparams() {
 	return(gain);
 
 }
+int TLowpassFilter::statesize()
+{
+	return 2 * sizeof(int) + 2 * sizeof(double) + sizeof(double); //one sample of history
+}
+
+char* TLowpassFilter::savestate(char* p)
+{
+	p = putstate(p, bfsize);
+	p = putstate(p, wIndex);
+	p = putstate(p, gain);
+	p = putstate(p, out);
+	return putring(p, dline, bfsize, wIndex, 1);
+}
+
+const char* TLowpassFilter::loadstate(const char* p, const char* end, bool apply)
+{
+	int size, w;
+	double g, o;
+	p = getstate(p, end, size);
+	p = getstate(p, end, w);
+	p = getstate(p, end, g);
+	p = getstate(p, end, o);
+	if (!p || size != bfsize) return nullptr;
+	p = getring(p, end, dline, bfsize, w, 1, apply);
+	if (p && apply)
+	{
+		wIndex = w;
+		gain = g;
+		out = o;
+	}
+	return p;
+}
+
 double TLowpassFilter::audioprocessing(double input)
 {
 	rIndex = wIndex - 1;
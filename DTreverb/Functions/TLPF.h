@@ -13,6 +13,9 @@ public:
 	void Buffersize(double sampleRate);
 	void setgainparams(const double a);
 	double getgainparams();
+	int statesize();
+	char* savestate(char* p);
+	const char* loadstate(const char* p, const char* end, bool apply);
 
 	int bfsize;
 	double out;
@@ -0,0 +1,65 @@
+#include "TapMatrix.h"
+#include "DTMath.h"
+
+//tap signs per output channel, taps in outdelay1..14 order. L and R are Dattorro's two output sums,
+//the other channels use different sign patterns over both halves of the tank so they stay decorrelated
+static const signed char layout[TapMatrix::maxrows][TapMatrix::taps] = {
+	//1   2   3   4   5   6   7   8   9  10  11  12  13  14
+	{ 1,  1,  0, -1,  0,  1,  0, -1,  0, -1,  0, -1,  0,  0 },  //L
+	{ 0,  0, -1,  0, -1,  0, -1,  0,  1,  0, -1,  0,  1,  1 },  //R
+	{ 1,  0, -1,  0,  1,  0, -1,  0,  0,  1,  0,  0, -1,  1 },  //C
+	{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0 },  //LFE
+	{ 0,  1,  1,  0, -1,  0,  0,  1,  0,  0,  1, -1,  0, -1 },  //Ls
+	{ 1,  0,  0,  1,  0,  0, -1,  0,  1, -1,  0,  1,  1,  0 },  //Rs
+	{ 0, -1,  0,  1,  0,  1,  0,  0,  1,  1, -1,  0,  0, -1 },  //Lrs
+	{-1,  0,  1,  0,  1,  0,  0,  1, -1,  0, -1,  0,  0,  1 },  //Rrs
+	{ 0,  1,  0,  0,  1, -1,  0, -1,  0, -1,  0,  1,  1,  0 },  //Ltf
+	{ 1,  0, -1,  1,  0,  0,  1,  0,  0,  1,  1,  0,  0, -1 },  //Rtf
+	{ 0,  0,  1,  1,  0,  0, -1,  1,  1,  0,  0, -1,  0,  1 },  //Ltr
+	{-1,  1,  0,  0,  0,  1,  0,  0, -1,  0,  1,  0, -1,  1 },  //Rtr
+};
+
+//centre and surrounds a little lower than the fronts, heights lower again
+static const double level[TapMatrix::maxrows] = { 1.0, 1.0, 0.5, 0.0, 0.8, 0.8, 0.7, 0.7, 0.6, 0.6, 0.6, 0.6 };
+
+TapMatrix::TapMatrix()
+{
+	setlayout(2);
+}
+
+void TapMatrix::setlayout(int outputs)
+{
+	rows = outputs < maxrows ? outputs : maxrows;
+	memset(coef, 0, sizeof(coef));
+
+	//channel order L R C LFE Ls Rs [Lrs Rrs] [Ltf Rtf Ltr Rtr]; unknown layouts only get L/R
+	int known = (outputs == 2 || outputs == 6 || outputs == 8 || outputs == 12) ? rows : 2;
+	for (int row = 0; row < known && row < rows; row++)
+		for (int tap = 0; tap < taps; tap++)
+			setgain(row, tap, layout[row][tap] * level[row]);
+}
+
+void TapMatrix::setgain(int row, int tap, double a)
+{
+	if (row < 0 || row >= maxrows || tap < 0 || tap >= taps) return;
+	coef[row / 2][tap][row & 1] = a;
+}
+
+double TapMatrix::getgain(int row, int tap)
+{
+	if (row < 0 || row >= maxrows || tap < 0 || tap >= taps) return 0.0;
+	return coef[row / 2][tap][row & 1];
+}
+
+void TapMatrix::audioprocessing(const double* input, double* output)
+{
+	for (int pair = 0; pair < (rows + 1) / 2; pair++)
+	{
+		dpair acc = pairset1(0.0);
+		for (int tap = 0; tap < taps; tap++)
+			acc = pairadd(acc, pairmul(pairload(coef[pair][tap]), pairset1(input[tap])));
+
+		output[2 * pair] = pairlo(acc);
+		if (2 * pair + 1 < rows) output[2 * pair + 1] = pairhi(acc);
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef TapMatrix_h
+#define TapMatrix_h
+#include <stdio.h>
+#include <string.h>
+#include "Simd.h"
+
+//output stage for more than two channels: every output is a weighted sum of the 14 tank taps.
+//Rows are stored in pairs, tap by tap, so two outputs come out of each multiply-add
+class TapMatrix {
+public:
+	static const int taps = 14;
+	static const int maxrows = 12;
+
+	TapMatrix();
+	void setlayout(int outputs);   //2, 6 (5.1), 8 (7.1) or 12 (7.1.4); other counts get L/R and silence
+	void setgain(int row, int tap, double a);
+	double getgain(int row, int tap);
+	void audioprocessing(const double* input, double* output);
+
+	int rows;
+
+private:
+	double coef[maxrows / 2][taps][2];
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include "allp.h"
+#include "DTMath.h"
+#include "State.h"
 #include <cmath>
 //comment for the basic strucutre of methods are cited in the Delayline.cpp
 allp::allp()
@@ -24,6 +26,7 @@ void allp::reset()
 }
 void allp::Buffersize(double samplingRate)
 {
+	if (bfsize == (int)samplingRate) { reset(); return; }
 	delete[] dline;
 	bfsize = samplingRate;
 	dline = new double[bfsize];
@@ -50,6 +53,54 @@ double allp::getgainparams() {
 
 }
 
+int allp::statesize()
+{
+	int history = (delay > 0 && delay <= bfsize) ? delay : bfsize;
+	return 4 * sizeof(int) + 4 * sizeof(double) + history * sizeof(double);
+}
+
+char* allp::savestate(char* p)
+{
+	int history = (delay > 0 && delay <= bfsize) ? delay : bfsize;
+	p = putstate(p, bfsize);
+	p = putstate(p, delay);
+	p = putstate(p, wIndex);
+	p = putstate(p, rIndex);
+	p = putstate(p, gain);
+	p = putstate(p, out);
+	p = putstate(p, d_out);
+	p = putstate(p, d_in);
+	return putring(p, dline, bfsize, wIndex, history);
+}
+
+const char* allp::loadstate(const char* p, const char* end, bool apply)
+{
+	int size, d, w, r;
+	double g, o, dout, din;
+	p = getstate(p, end, size);
+	p = getstate(p, end, d);
+	p = getstate(p, end, w);
+	p = getstate(p, end, r);
+	p = getstate(p, end, g);
+	p = getstate(p, end, o);
+	p = getstate(p, end, dout);
+	p = getstate(p, end, din);
+	if (!p || size != bfsize || d < 0 || d > bfsize || r < 0 || r >= bfsize) return nullptr;
+	int history = d > 0 ? d : bfsize;
+	p = getring(p, end, dline, bfsize, w, history, apply);
+	if (p && apply)
+	{
+		delay = d;
+		wIndex = w;
+		rIndex = r;
+		gain = g;
+		out = o;
+		d_out = dout;
+		d_in = din;
+	}
+	return p;
+}
+
 double allp::audioprocessing(double input)
 {
 	rIndex = wIndex - delay;
@@ -1,5 +1,7 @@
 #define _USE_MATH_DEFINES
 #include "mAllp.h"
+#include "DTMath.h"
+#include "State.h"
 #include <cmath>
 //comment for the basic strucutre of methods are cited in the Delayline.cpp
 MAllp::MAllp()
@@ -25,6 +27,7 @@ void MAllp::reset()
 }
 void MAllp::Buffersize(double samplingRate)
 {
+	if (bfsize == (int)samplingRate) { reset(); return; }
 	delete[] dline;
 	bfsize = samplingRate;
 	dline = new double[bfsize];
@@ -52,11 +55,65 @@ double MAllp::getgainparams() {
 
 }
 void MAllp::excursion(double sampleRate) {
-	sine_float = 2 * (round(8*(sampleRate/29761)))* (sin(2 * M_PI * 1 / sampleRate) + 1); ///lfoIndex =1  1Hz LFO delay modulation; excursion = round(8*(converted samplerate) , referenced from dattorro's journal
+	sine_float = 2 * (round(8*(sampleRate/29761)))* (dtsin(2 * M_PI * 1 / sampleRate) + 1); ///lfoIndex =1  1Hz LFO delay modulation; excursion = round(8*(converted samplerate) , referenced from dattorro's journal
 	sine_int = ceil(sine_float);  //this will modulate the delaytime 
 }    //29761 is the original sampling frequency of dattorro's reverb algorithm 
 
 
+int MAllp::statesize()
+{
+	int history = (delay > 0 && delay <= bfsize) ? delay : bfsize;
+	return 4 * sizeof(int) + 6 * sizeof(double) + history * sizeof(double);
+}
+
+char* MAllp::savestate(char* p)
+{
+	int history = (delay > 0 && delay <= bfsize) ? delay : bfsize;
+	p = putstate(p, bfsize);
+	p = putstate(p, delay);
+	p = putstate(p, wIndex);
+	p = putstate(p, rIndex);
+	p = putstate(p, gain);
+	p = putstate(p, out);
+	p = putstate(p, d_out);
+	p = putstate(p, d_in);
+	p = putstate(p, sine_float);
+	p = putstate(p, sine_int);
+	return putring(p, dline, bfsize, wIndex, history);
+}
+
+const char* MAllp::loadstate(const char* p, const char* end, bool apply)
+{
+	int size, d, w, r;
+	double g, o, dout, din, sf, si;
+	p = getstate(p, end, size);
+	p = getstate(p, end, d);
+	p = getstate(p, end, w);
+	p = getstate(p, end, r);
+	p = getstate(p, end, g);
+	p = getstate(p, end, o);
+	p = getstate(p, end, dout);
+	p = getstate(p, end, din);
+	p = getstate(p, end, sf);
+	p = getstate(p, end, si);
+	if (!p || size != bfsize || d < 0 || d > bfsize || r < 0 || r >= bfsize) return nullptr;
+	int history = d > 0 ? d : bfsize;
+	p = getring(p, end, dline, bfsize, w, history, apply);
+	if (p && apply)
+	{
+		delay = d;
+		wIndex = w;
+		rIndex = r;
+		gain = g;
+		out = o;
+		d_out = dout;
+		d_in = din;
+		sine_float = sf;
+		sine_int = si;
+	}
+	return p;
+}
+
 double MAllp::audioprocessing(double input)
 {
 	rIndex = wIndex - delay;
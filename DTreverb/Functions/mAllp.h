@@ -16,6 +16,9 @@ public:
 	void setdelaytime(double sampleRate, int _delay);
 	void setgainparams(const double a);
 	double getgainparams();
+	int statesize();
+	char* savestate(char* p);
+	const char* loadstate(const char* p, const char* end, bool apply);
 
 
 	int bfsize;
@@ -0,0 +1,240 @@
+#include "BatchRender.h"
+#include "WavFile.h"
+#include <thread>
+#include <chrono>
+
+//processAudioFrame fires MIDI for every frame, offline there is never any
+class NullMidiEventQueue : public IMidiEventQueue {
+public:
+	uint32_t getEventCount() { return 0; }
+	bool fireMidiEvents(uint32_t uSampleOffset) { return true; }
+};
+static NullMidiEventQueue nullMidiQueue;
+
+OfflineCore::OfflineCore()
+{
+	PluginInfo info;
+	core.initialize(info);
+	core.setOfflineRendering(true);
+	bufferInfo.hostInfo = &hostInfo;
+	bufferInfo.midiEventQueue = &nullMidiQueue;
+}
+
+void OfflineCore::prepare(double sampleRate, const std::vector<PresetParameter>& parameters)
+{
+	hostInfo = HostInfo();
+
+	//parameters first: reset() applies the ones that size buffers, like a host restarting after a latency change;
+	//everything goes back to its default so nothing carries over from the previous job
+	ParameterUpdateInfo paramInfo;
+	for (size_t i = 0; i < core.getPluginParameterCount(); i++)
+	{
+		PluginParameter* piParam = core.getPluginParameterByIndex((int32_t)i);
+		if (!piParam->isMeterParam())
+			core.updatePluginParameter(piParam->getControlID(), piParam->getDefaultValue(), paramInfo);
+	}
+	for (size_t i = 0; i < parameters.size(); i++)
+		core.updatePluginParameter(parameters[i].controlID, parameters[i].actualValue, paramInfo);
+	core.syncInBoundVariables();
+
+	ResetInfo resetInfo(sampleRate, 32);
+	core.reset(resetInfo);
+
+	//cook everything once, reset() puts the delay objects back to their construction values
+	for (size_t i = 0; i < core.getPluginParameterCount(); i++)
+	{
+		PluginParameter* piParam = core.getPluginParameterByIndex((int32_t)i);
+		core.postUpdatePluginParameter(piParam->getControlID(), piParam->getControlValue(), paramInfo);
+	}
+}
+
+void OfflineCore::process(float** inputs, float** outputs, uint32_t numInChannels, uint32_t frames)
+{
+	bufferInfo.inputs = inputs;
+	bufferInfo.outputs = outputs;
+	bufferInfo.numAudioInChannels = numInChannels;
+	bufferInfo.numAudioOutChannels = 2;
+	bufferInfo.numFramesToProcess = frames;
+	bufferInfo.channelIOConfig = ChannelIOConfig(numInChannels == 1 ? kCFMono : kCFStereo, kCFStereo);
+	core.processAudioBuffers(bufferInfo);
+}
+
+BatchRenderer::BatchRenderer(int _numThreads)
+{
+	numThreads = _numThreads > 0 ? _numThreads : (int)std::thread::hardware_concurrency();
+	if (numThreads < 1) numThreads = 1;
+	tailSeconds = 0.0;
+	wallSeconds = 0.0;
+	generation = 0;
+	busy = 0;
+	quit = false;
+	batchJobs = nullptr;
+	batchResults = nullptr;
+
+	//instances, buffers and threads are built once, up front; workers only reset them between files
+	for (int i = 0; i < numThreads; i++)
+	{
+		workers.push_back(std::unique_ptr<Worker>(new Worker));
+		workers.back()->buffer.resize(4 * OfflineCore::blockSize);
+	}
+	for (size_t i = 0; i < workers.size(); i++)
+		threads.push_back(std::thread(&BatchRenderer::workerLoop, this, i));
+}
+
+BatchRenderer::~BatchRenderer()
+{
+	{
+		std::lock_guard<std::mutex> guard(poolLock);
+		quit = true;
+	}
+	wake.notify_all();
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+}
+
+void BatchRenderer::workerLoop(size_t self)
+{
+	uint64_t seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> guard(poolLock);
+			wake.wait(guard, [this, seen]() { return quit || generation != seen; });
+			if (quit)
+				return;
+			seen = generation;
+		}
+
+		size_t job;
+		while (nextJob(self, job))
+		{
+			(*batchResults)[job] = renderFile(*workers[self], (*batchJobs)[job]);
+			(*batchResults)[job].worker = (int)self;
+		}
+
+		std::lock_guard<std::mutex> guard(poolLock);
+		if (--busy == 0)
+			done.notify_all();
+	}
+}
+
+bool BatchRenderer::nextJob(size_t self, size_t& job)
+{
+	{
+		std::lock_guard<std::mutex> guard(workers[self]->lock);
+		if (!workers[self]->queue.empty())
+		{
+			job = workers[self]->queue.front();
+			workers[self]->queue.pop_front();
+			return true;
+		}
+	}
+
+	//own queue ran dry: steal the last job of the next worker that still has some
+	for (size_t i = 1; i < workers.size(); i++)
+	{
+		Worker* victim = workers[(self + i) % workers.size()].get();
+		std::lock_guard<std::mutex> guard(victim->lock);
+		if (!victim->queue.empty())
+		{
+			job = victim->queue.back();
+			victim->queue.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+RenderResult BatchRenderer::renderFile(Worker& worker, const RenderJob& job)
+{
+	RenderResult result;
+	result.inPath = job.inPath;
+
+	auto start = std::chrono::steady_clock::now();
+
+	WavReader reader;
+	WavWriter writer;
+	if (!reader.open(job.inPath.c_str()) || reader.numChannels == 0 || reader.numChannels > 2 ||
+		!writer.open(job.outPath.c_str(), 2, reader.sampleRate))
+		return result;
+
+	worker.engine.prepare(reader.sampleRate, parameters);
+
+	const uint32_t blockSize = OfflineCore::blockSize;
+	float* in[2] = { &worker.buffer[0], &worker.buffer[blockSize] };
+	float* out[2] = { &worker.buffer[2 * blockSize], &worker.buffer[3 * blockSize] };
+
+	bool ok = true;
+	uint64_t tailFrames = (uint64_t)(tailSeconds * reader.sampleRate);
+	uint32_t frames;
+	while ((frames = reader.readFrames(in, blockSize)) > 0 && ok)
+	{
+		worker.engine.process(in, out, reader.numChannels, frames);
+		ok = writer.writeFrames(out, frames);
+	}
+
+	//let the tank ring out on silence
+	memset(in[0], 0, 2 * blockSize * sizeof(float));
+	while (tailFrames > 0 && ok)
+	{
+		frames = tailFrames < blockSize ? (uint32_t)tailFrames : blockSize;
+		worker.engine.process(in, out, reader.numChannels, frames);
+		ok = writer.writeFrames(out, frames);
+		tailFrames -= frames;
+	}
+
+	result.ok = writer.close() && ok;
+	result.frames = writer.framesWritten;
+	result.sampleRate = reader.sampleRate;
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+std::vector<RenderResult> BatchRenderer::run(const std::vector<RenderJob>& jobs)
+{
+	std::vector<RenderResult> results(jobs.size());
+
+	//the workers are all asleep between runs, so the queues can be filled without racing them
+	for (size_t i = 0; i < jobs.size(); i++)
+		workers[i % workers.size()]->queue.push_back(i);
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::unique_lock<std::mutex> guard(poolLock);
+	batchJobs = &jobs;
+	batchResults = &results;
+	busy = (int)workers.size();
+	generation++;
+	wake.notify_all();
+	done.wait(guard, [this]() { return busy == 0; });
+	batchJobs = nullptr;
+	batchResults = nullptr;
+	guard.unlock();
+
+	wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return results;
+}
+
+void BatchRenderer::report(const std::vector<RenderResult>& results, FILE* out)
+{
+	double audioSeconds = 0.0;
+	double cpuSeconds = 0.0;
+	int failed = 0;
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const RenderResult& r = results[i];
+		double length = r.sampleRate > 0 ? r.frames / r.sampleRate : 0.0;
+		fprintf(out, "%-48s %s worker %2d  %9.3f s audio  %8.3f s  %7.1fx\n", r.inPath.c_str(), r.ok ? "ok    " : "FAILED",
+			r.worker, length, r.seconds, r.seconds > 0 ? length / r.seconds : 0.0);
+		audioSeconds += length;
+		cpuSeconds += r.seconds;
+		if (!r.ok) failed++;
+	}
+
+	fprintf(out, "%d files, %d failed, %d workers: %.3f s audio in %.3f s wall (%.1fx realtime, %.2f parallel efficiency)\n",
+		(int)results.size(), failed, numThreads, audioSeconds, wallSeconds,
+		wallSeconds > 0 ? audioSeconds / wallSeconds : 0.0,
+		wallSeconds > 0 ? cpuSeconds / (wallSeconds * numThreads) : 0.0);
+}
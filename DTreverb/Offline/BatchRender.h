@@ -0,0 +1,86 @@
+#ifndef BatchRender_h
+#define BatchRender_h
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <condition_variable>
+#include "plugincore.h"
+
+//one file to render; the output is always a stereo 32-bit float WAV
+struct RenderJob {
+	std::string inPath;
+	std::string outPath;
+};
+
+//per-file result, filled in by whichever worker ran the job
+struct RenderResult {
+	std::string inPath;
+	bool ok = false;
+	uint64_t frames = 0;
+	double sampleRate = 0.0;
+	double seconds = 0.0;  //wall time for this file
+	int worker = -1;
+};
+
+//PluginCore instance driven without a host; also used by the segment and cache renderers
+class OfflineCore {
+public:
+	OfflineCore();
+
+	void prepare(double sampleRate, const std::vector<PresetParameter>& parameters);  //reset + push every parameter through the cooking path
+	void process(float** inputs, float** outputs, uint32_t numInChannels, uint32_t frames);
+
+	PluginCore core;
+	static const uint32_t blockSize = 512;
+
+private:
+	HostInfo hostInfo;
+	ProcessBufferInfo bufferInfo;
+};
+
+//renders a list of files on a fixed-size pool of workers, each owning one preallocated OfflineCore;
+//the pool is built once and reused by every run()
+class BatchRenderer {
+public:
+	BatchRenderer(int _numThreads = 0);  //0 = one worker per hardware thread
+	~BatchRenderer();
+
+	std::vector<RenderResult> run(const std::vector<RenderJob>& jobs);
+	void report(const std::vector<RenderResult>& results, FILE* out = stdout);
+
+	std::vector<PresetParameter> parameters;  //settings applied to every file, empty = plugin defaults
+	double tailSeconds;                        //silence rendered after the input so the tail is not cut
+	int numThreads;                            //fixed at construction
+
+private:
+	struct Worker {
+		std::deque<size_t> queue;
+		std::mutex lock;
+		OfflineCore engine;
+		std::vector<float> buffer;  //in L/R + out L/R, blockSize each
+	};
+
+	void workerLoop(size_t self);            //sleeps between runs, drains the queues during one
+	bool nextJob(size_t self, size_t& job);  //own queue from the front, steal from the back of the others
+	RenderResult renderFile(Worker& worker, const RenderJob& job);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+	double wallSeconds;
+
+	//dispatch: run() bumps the generation and waits until every worker has drained the queues
+	std::mutex poolLock;
+	std::condition_variable wake;
+	std::condition_variable done;
+	uint64_t generation;
+	int busy;
+	bool quit;
+	const std::vector<RenderJob>* batchJobs;
+	std::vector<RenderResult>* batchResults;
+};
+
+#endif
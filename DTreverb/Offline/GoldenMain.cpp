@@ -0,0 +1,77 @@
+//command line runner for the golden render harness, for CI:
+//
+//  golden [--record] [--tolerance rmsDb maxDb] [--diff-block frames] [--no-isolation] [--case text] directory
+//
+//compares the default matrix against directory/<case>.wav, bit exact unless --tolerance is given;
+//--record writes the goldens instead. Exit code 0 when every case passed, 1 on a failure, 2 on bad usage
+#include "GoldenRender.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int usage()
+{
+	fprintf(stderr, "usage: golden [--record] [--tolerance rmsDb maxDb] [--diff-block frames] [--no-isolation] [--case text] directory\n");
+	return 2;
+}
+
+int main(int argc, char** argv)
+{
+	const char* directory = nullptr;
+	const char* filter = nullptr;
+	bool record = false;
+	bool bitExact = true;
+	bool isolation = true;
+	double toleranceDb = 0.0;
+	double maxErrorDb = 0.0;
+	long diffBlock = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--record") == 0) record = true;
+		else if (strcmp(argv[i], "--no-isolation") == 0) isolation = false;
+		else if (strcmp(argv[i], "--tolerance") == 0 && i + 2 < argc)
+		{
+			bitExact = false;
+			toleranceDb = atof(argv[++i]);
+			maxErrorDb = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--diff-block") == 0 && i + 1 < argc)
+		{
+			diffBlock = atol(argv[++i]);
+			if (diffBlock <= 0) return usage();
+		}
+		else if (strcmp(argv[i], "--case") == 0 && i + 1 < argc) filter = argv[++i];
+		else if (argv[i][0] == '-' || directory) return usage();
+		else directory = argv[i];
+	}
+	if (!directory) return usage();
+
+	GoldenHarness harness(directory);
+	harness.record = record;
+	harness.isolation = isolation;
+	harness.bitExact = bitExact;
+	if (!bitExact)
+	{
+		harness.toleranceDb = toleranceDb;
+		harness.maxErrorDb = maxErrorDb;
+	}
+	if (diffBlock > 0) harness.diffBlock = (uint32_t)diffBlock;
+
+	//--case keeps the cases whose name contains the text
+	std::vector<GoldenCase> cases = GoldenHarness::defaultMatrix();
+	if (filter)
+	{
+		std::vector<GoldenCase> selected;
+		for (size_t i = 0; i < cases.size(); i++)
+			if (cases[i].name.find(filter) != std::string::npos) selected.push_back(cases[i]);
+		cases.swap(selected);
+		if (cases.empty())
+		{
+			fprintf(stderr, "golden: no case matches \"%s\"\n", filter);
+			return 2;
+		}
+	}
+
+	std::vector<GoldenResult> results = harness.run(cases);
+	return harness.report(results, stdout) ? 0 : 1;
+}
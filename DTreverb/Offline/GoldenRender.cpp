@@ -0,0 +1,293 @@
+#include "GoldenRender.h"
+#include "WavFile.h"
+#include "DTMath.h"
+#include <cmath>
+#include <algorithm>
+
+GoldenHarness::GoldenHarness(const char* _directory)
+{
+	directory = _directory;
+	record = false;
+	bitExact = true;
+	toleranceDb = -120.0;
+	maxErrorDb = -100.0;
+	diffBlock = 4800;
+	isolation = true;
+}
+
+void GoldenHarness::makeStimulus(int stimulus, double sampleRate, std::vector<float> signal[2])
+{
+	size_t length = signal[0].size();
+	for (uint32_t c = 0; c < 2; c++)
+		std::fill(signal[c].begin(), signal[c].end(), 0.f);
+	if (length == 0) return;
+
+	size_t active = length / 2;
+	if (stimulus == kGoldenImpulse)
+	{
+		//left at 0, right 10 ms later, so a swapped or summed input path shows up
+		signal[0][0] = 1.f;
+		signal[1][(size_t)(0.01 * sampleRate) < length ? (size_t)(0.01 * sampleRate) : 0] = 1.f;
+	}
+	else if (stimulus == kGoldenSweep)
+	{
+		//exponential sweep 20 Hz to 0.45 fs, inverted on the right; DTMath so the stimulus is as portable as the render
+		double f1 = 20.0;
+		double f2 = 0.45 * sampleRate;
+		double T = active / sampleRate;
+		double L = T / dtlog(f2 / f1);
+		size_t fade = (size_t)(0.01 * sampleRate);
+		for (size_t i = 0; i < active; i++)
+		{
+			double t = i / sampleRate;
+			double g = 0.5;
+			if (i < fade) g *= (double)i / fade;
+			if (active - i < fade) g *= (double)(active - i) / fade;
+			float x = (float)(g * dtsin(2 * M_PI * f1 * L * (dtexp(t / L) - 1)));
+			signal[0][i] = x;
+			signal[1][i] = -x;
+		}
+	}
+	else if (stimulus == kGoldenNoise)
+	{
+		//xorshift white noise, independent per channel
+		uint32_t state[2] = { 0x12345678u, 0x9e3779b9u };
+		for (uint32_t c = 0; c < 2; c++)
+		{
+			for (size_t i = 0; i < active; i++)
+			{
+				state[c] ^= state[c] << 13;
+				state[c] ^= state[c] >> 17;
+				state[c] ^= state[c] << 5;
+				signal[c][i] = (float)(0.25 * ((int32_t)state[c] / 2147483648.0));
+			}
+		}
+	}
+}
+
+std::vector<GoldenCase> GoldenHarness::defaultMatrix()
+{
+	struct Setting {
+		const char* name;
+		std::vector<PresetParameter> parameters;
+	};
+	std::vector<Setting> settings = {
+		{ "dattorro", {} },
+		{ "dattorro_long", { PresetParameter(controlID::decayfactor, 0.85), PresetParameter(controlID::damping, 0.1),
+			PresetParameter(controlID::diffusion, 0.7), PresetParameter(controlID::modulation, 50.0),
+			PresetParameter(controlID::stereomode, 1), PresetParameter(controlID::earlylevel, 40.0),
+			PresetParameter(controlID::wetdry, 70.0), PresetParameter(controlID::predelaytime, 25.0) } },
+		{ "dattorro_os2", { PresetParameter(controlID::oversampling, 1) } },
+		{ "dattorro_buffered", { PresetParameter(controlID::processing, 1) } },
+		{ "fdn4", { PresetParameter(controlID::algorithm, 1) } },
+		{ "fdn16_householder", { PresetParameter(controlID::algorithm, 3), PresetParameter(controlID::fdnmatrix, 1),
+			PresetParameter(controlID::decayfactor, 0.8) } },
+		{ "convolution", { PresetParameter(controlID::engine, 1) } },
+	};
+	const double rates[] = { 44100.0, 48000.0, 96000.0 };
+	const char* stimuli[] = { "impulse", "sweep", "noise" };
+
+	std::vector<GoldenCase> cases;
+	for (size_t s = 0; s < settings.size(); s++)
+	{
+		for (int r = 0; r < 3; r++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				GoldenCase test;
+				test.name = std::string(settings[s].name) + "_" + std::to_string((int)(rates[r] / 1000)) + "k_" + stimuli[k];
+				test.parameters = settings[s].parameters;
+				test.sampleRate = rates[r];
+				test.stimulus = k;
+				cases.push_back(test);
+			}
+		}
+	}
+	return cases;
+}
+
+bool GoldenHarness::renderCase(OfflineCore& core, const GoldenCase& test, std::vector<float> output[2])
+{
+	size_t length = (size_t)(test.seconds * test.sampleRate);
+	std::vector<float> input[2];
+	for (uint32_t c = 0; c < 2; c++)
+	{
+		input[c].resize(length);
+		output[c].resize(length);
+	}
+	makeStimulus(test.stimulus, test.sampleRate, input);
+
+	core.prepare(test.sampleRate, test.parameters);
+
+	//fixed block size: block boundaries are part of what the golden pins down
+	const uint32_t blockSize = OfflineCore::blockSize;
+	for (size_t pos = 0; pos < length; pos += blockSize)
+	{
+		uint32_t frames = length - pos < blockSize ? (uint32_t)(length - pos) : blockSize;
+		float* in[2] = { &input[0][pos], &input[1][pos] };
+		float* out[2] = { &output[0][pos], &output[1][pos] };
+		core.process(in, out, 2, frames);
+	}
+	return true;
+}
+
+static bool sameBits(const std::vector<float> a[2], const std::vector<float> b[2])
+{
+	for (uint32_t c = 0; c < 2; c++)
+		if (a[c].size() != b[c].size() || (!a[c].empty() && memcmp(&a[c][0], &b[c][0], a[c].size() * sizeof(float)) != 0))
+			return false;
+	return true;
+}
+
+bool GoldenHarness::isolated(const GoldenCase& test, const std::vector<float> output[2])
+{
+	//the shared engine has just rendered this case after the previous one; a fresh engine and a
+	//second pass through the shared one have to give the same bits
+	std::vector<float> again[2];
+	OfflineCore fresh;
+	renderCase(fresh, test, again);
+	bool same = sameBits(again, output);
+	renderCase(engine, test, again);
+	return same && sameBits(again, output);
+}
+
+bool GoldenHarness::writeWav(const std::string& path, double sampleRate, const std::vector<float> output[2])
+{
+	WavWriter writer;
+	if (!writer.open(path.c_str(), 2, (uint32_t)sampleRate)) return false;
+	float* range[2] = { (float*)&output[0][0], (float*)&output[1][0] };
+	bool ok = output[0].empty() || writer.writeFrames(range, (uint32_t)output[0].size());
+	return writer.close() && ok;
+}
+
+bool GoldenHarness::compare(const GoldenCase& test, const std::vector<float> output[2], GoldenResult& result)
+{
+	size_t length = output[0].size();
+	result.frames = length;
+	result.firstDiff = length;
+
+	WavReader reader;
+	if (!reader.open((directory + "/" + test.name + ".wav").c_str()) || reader.numChannels != 2 ||
+		reader.sampleRate != (uint32_t)test.sampleRate || reader.numFrames != length)
+	{
+		result.missing = true;
+		return false;
+	}
+	std::vector<float> golden[2];
+	golden[0].resize(length);
+	golden[1].resize(length);
+	float* range[2] = { &golden[0][0], &golden[1][0] };
+	if (length > 0 && reader.readFrames(range, (uint32_t)length) != length)
+	{
+		result.missing = true;
+		return false;
+	}
+
+	double errorEnergy = 0.0;
+	double signalEnergy = 0.0;
+	bool identical = true;
+	for (uint32_t c = 0; c < 2; c++)
+	{
+		for (size_t i = 0; i < length; i++)
+		{
+			//bit compare, so a NaN or a -0 against +0 also counts
+			if (memcmp(&golden[c][i], &output[c][i], sizeof(float)) != 0)
+			{
+				identical = false;
+				if (i < result.firstDiff) result.firstDiff = i;
+			}
+			double e = (double)output[c][i] - golden[c][i];
+			if (!(fabs(e) <= result.maxError)) result.maxError = fabs(e);
+			errorEnergy += e * e;
+			signalEnergy += (double)golden[c][i] * golden[c][i];
+		}
+	}
+	if (result.maxError > 0) result.maxErrorDb = 20 * log10(result.maxError);
+	if (errorEnergy > 0) result.rmsErrorDb = signalEnergy > 0 ? 10 * log10(errorEnergy / signalEnergy) : 200.0;
+
+	bool ok = bitExact ? identical : result.rmsErrorDb <= toleranceDb && result.maxErrorDb <= maxErrorDb;
+	if (!ok)
+	{
+		//a plottable envelope of golden, output and error, plus the render itself to listen to
+		result.diffPath = directory + "/" + test.name + ".diff.csv";
+		writeDiff(result.diffPath, test.sampleRate, golden, output);
+		writeWav(directory + "/" + test.name + ".new.wav", test.sampleRate, output);
+	}
+	return ok;
+}
+
+bool GoldenHarness::writeDiff(const std::string& path, double sampleRate, const std::vector<float> golden[2], const std::vector<float> output[2])
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file) return false;
+
+	fprintf(file, "time,goldenL_db,outputL_db,errorL_db,maxerrorL,goldenR_db,outputR_db,errorR_db,maxerrorR\n");
+	size_t length = output[0].size();
+	uint32_t block = diffBlock > 0 ? diffBlock : 1;
+	for (size_t pos = 0; pos < length; pos += block)
+	{
+		size_t end = pos + block < length ? pos + block : length;
+		fprintf(file, "%.4f", pos / sampleRate);
+		for (uint32_t c = 0; c < 2; c++)
+		{
+			double g = 0.0, o = 0.0, e = 0.0, m = 0.0;
+			for (size_t i = pos; i < end; i++)
+			{
+				double d = (double)output[c][i] - golden[c][i];
+				g += (double)golden[c][i] * golden[c][i];
+				o += (double)output[c][i] * output[c][i];
+				e += d * d;
+				if (fabs(d) > m) m = fabs(d);
+			}
+			double n = (double)(end - pos);
+			fprintf(file, ",%.2f,%.2f,%.2f,%.3g", 10 * log10(g / n + 1e-30), 10 * log10(o / n + 1e-30), 10 * log10(e / n + 1e-30), m);
+		}
+		fprintf(file, "\n");
+	}
+	return fclose(file) == 0;
+}
+
+std::vector<GoldenResult> GoldenHarness::run(const std::vector<GoldenCase>& cases)
+{
+	std::vector<GoldenResult> results(cases.size());
+	std::vector<float> output[2];
+	for (size_t i = 0; i < cases.size(); i++)
+	{
+		GoldenResult& result = results[i];
+		result.name = cases[i].name;
+		renderCase(engine, cases[i], output);
+		if (isolation && !isolated(cases[i], output))
+		{
+			result.leaked = true;
+			result.frames = output[0].size();
+			continue;
+		}
+		if (record)
+		{
+			result.frames = output[0].size();
+			result.firstDiff = result.frames;
+			result.ok = writeWav(directory + "/" + cases[i].name + ".wav", cases[i].sampleRate, output);
+		}
+		else
+			result.ok = compare(cases[i], output, result);
+	}
+	return results;
+}
+
+bool GoldenHarness::report(const std::vector<GoldenResult>& results, FILE* out)
+{
+	int failed = 0;
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const GoldenResult& r = results[i];
+		if (r.ok) fprintf(out, "%-40s %s\n", r.name.c_str(), record ? "recorded" : "ok");
+		else if (r.leaked) fprintf(out, "%-40s FAILED: depends on the cases rendered before it\n", r.name.c_str());
+		else if (r.missing || record) fprintf(out, "%-40s FAILED: %s\n", r.name.c_str(), record ? "could not write golden" : "golden missing or unreadable");
+		else fprintf(out, "%-40s FAILED: first diff at frame %llu, max error %.1f dBFS, rms error %.1f dB, see %s\n", r.name.c_str(),
+			(unsigned long long)r.firstDiff, r.maxErrorDb, r.rmsErrorDb, r.diffPath.c_str());
+		if (!r.ok) failed++;
+	}
+	fprintf(out, "%d cases, %d failed (%s)\n", (int)results.size(), failed,
+		record ? "record" : bitExact ? "bit exact" : "tolerance");
+	return failed == 0;
+}
@@ -0,0 +1,63 @@
+#ifndef GoldenRender_h
+#define GoldenRender_h
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "BatchRender.h"
+
+//test signals, all deterministic: the same case renders the same input on every machine
+enum goldenStimulus { kGoldenImpulse, kGoldenSweep, kGoldenNoise };
+
+//one render: a parameter setting, a sample rate and a stimulus; the golden file is directory/name.wav
+struct GoldenCase {
+	std::string name;
+	std::vector<PresetParameter> parameters;
+	double sampleRate = 48000.0;
+	int stimulus = kGoldenImpulse;
+	double seconds = 2.0;  //total length, the stimulus takes the first half at most
+};
+
+struct GoldenResult {
+	std::string name;
+	bool ok = false;
+	bool missing = false;         //no golden file, or it could not be read
+	bool leaked = false;          //renders differently alone, after the previous case or twice in a row
+	uint64_t frames = 0;
+	uint64_t firstDiff = 0;       //first frame that is not bit identical, == frames when none
+	double maxError = 0.0;        //largest absolute sample difference
+	double maxErrorDb = -200.0;   //the same in dBFS
+	double rmsErrorDb = -200.0;   //error RMS relative to the golden RMS
+	std::string diffPath;         //per-block CSV written on failure
+};
+
+//renders a matrix of cases through OfflineCore and compares them against stored golden renders,
+//either bit exact or within a dB tolerance; record mode writes the goldens instead
+class GoldenHarness {
+public:
+	GoldenHarness(const char* _directory);
+
+	std::vector<GoldenResult> run(const std::vector<GoldenCase>& cases);
+	bool report(const std::vector<GoldenResult>& results, FILE* out = stdout);  //true when every case passed
+
+	static std::vector<GoldenCase> defaultMatrix();  //every engine and topology at 44.1/48/96 kHz with each stimulus
+	static void makeStimulus(int stimulus, double sampleRate, std::vector<float> signal[2]);
+
+	std::string directory;
+	bool record;           //write goldens instead of comparing
+	bool bitExact;         //any differing bit fails; otherwise the two limits below apply
+	double toleranceDb;    //allowed error RMS relative to the golden RMS
+	double maxErrorDb;     //allowed largest sample error in dBFS
+	uint32_t diffBlock;    //frames per CSV row
+	bool isolation;        //also render each case on a fresh engine and once more on the shared one, all bit identical
+
+private:
+	bool renderCase(OfflineCore& core, const GoldenCase& test, std::vector<float> output[2]);
+	bool isolated(const GoldenCase& test, const std::vector<float> output[2]);
+	bool compare(const GoldenCase& test, const std::vector<float> output[2], GoldenResult& result);
+	bool writeDiff(const std::string& path, double sampleRate, const std::vector<float> golden[2], const std::vector<float> output[2]);
+	bool writeWav(const std::string& path, double sampleRate, const std::vector<float> output[2]);
+
+	OfflineCore engine;
+};
+
+#endif
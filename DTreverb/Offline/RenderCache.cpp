@@ -0,0 +1,180 @@
+#include "RenderCache.h"
+#include <thread>
+#include <chrono>
+#include <functional>
+
+//cache file: this header, then frames * 2 interleaved 32-bit floats
+struct CacheHeader {
+	char magic[4];
+	uint32_t format;
+	uint64_t input;      //hash of the decoded input audio
+	uint64_t settings;   //hash of everything else that shapes the render
+	uint32_t sampleRate;
+	uint32_t numChannels;
+	uint64_t frames;
+	uint64_t reserved;
+};
+static const char kCacheMagic[4] = { 'D', 'T', 'r', 'c' };
+static const uint32_t kCacheFormat = 1;
+
+RenderCache::RenderCache(const char* _directory)
+{
+	directory = _directory;
+	tailSeconds = 0.0;
+	buffer.resize(6 * OfflineCore::blockSize);
+}
+
+bool RenderCache::inputHash(WavReader& reader, uint64_t& hash)
+{
+	//decoded samples, not file bytes: metadata chunks and sample format do not change the render
+	Fnv1a fnv;
+	fnv.add(reader.numChannels);
+	fnv.add(reader.sampleRate);
+	fnv.add(reader.numFrames);
+
+	const uint32_t blockSize = OfflineCore::blockSize;
+	float* in[2] = { &buffer[0], &buffer[blockSize] };
+	uint32_t frames;
+	while ((frames = reader.readFrames(in, blockSize)) > 0)
+		for (uint32_t c = 0; c < reader.numChannels; c++)
+			fnv.add(in[c], frames * sizeof(float));
+
+	hash = fnv.hash;
+	return reader.rewind();
+}
+
+uint64_t RenderCache::settingsHash(uint32_t sampleRate, uint64_t frames)
+{
+	Fnv1a fnv;
+	fnv.add(PluginCore::engineVersion);
+#ifdef DTREVERB_DETERMINISTIC
+	fnv.add((uint32_t)1);
+#else
+	fnv.add((uint32_t)0);
+#endif
+	fnv.add(sampleRate);
+	fnv.add(frames);
+
+	//every parameter the DSP reads, at its default unless overridden; meters, the GUI size and
+	//the load meter threshold do not change the audio
+	for (size_t i = 0; i < reference.core.getPluginParameterCount(); i++)
+	{
+		PluginParameter* piParam = reference.core.getPluginParameterByIndex((int32_t)i);
+		uint32_t controlID = piParam->getControlID();
+		if (piParam->isMeterParam() || piParam->isNonVariableBoundParam() || controlID == controlID::nearmiss) continue;
+
+		double value = piParam->getDefaultValue();
+		for (size_t k = 0; k < parameters.size(); k++)
+			if (parameters[k].controlID == controlID) value = parameters[k].actualValue;
+		fnv.add(controlID);
+		fnv.add(value);
+	}
+	return fnv.hash;
+}
+
+bool RenderCache::lookup(const std::string& path, uint64_t input, uint64_t settings, CachedRender& result)
+{
+	if (!result.map.open(path.c_str()) || result.map.size < sizeof(CacheHeader)) return false;
+
+	CacheHeader header;
+	memcpy(&header, result.map.data, sizeof(header));
+	if (memcmp(header.magic, kCacheMagic, 4) != 0 || header.format != kCacheFormat || header.input != input ||
+		header.settings != settings || header.numChannels != 2 ||
+		result.map.size != sizeof(CacheHeader) + header.frames * 2 * sizeof(float))
+	{
+		result.map.close();
+		return false;
+	}
+
+	result.samples = (const float*)(result.map.data + sizeof(CacheHeader));
+	result.frames = header.frames;
+	result.sampleRate = header.sampleRate;
+	return true;
+}
+
+bool RenderCache::store(const std::string& path, WavReader& reader, uint64_t input, uint64_t settings, uint64_t frames)
+{
+	//written under a private name and renamed into place, so other workers never map a partial file
+	size_t unique = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+		(size_t)std::chrono::steady_clock::now().time_since_epoch().count();
+	std::string temp = path + "." + std::to_string(unique) + ".tmp";
+	FILE* file = fopen(temp.c_str(), "wb");
+	if (!file) return false;
+
+	CacheHeader header = {};
+	memcpy(header.magic, kCacheMagic, 4);
+	header.format = kCacheFormat;
+	header.input = input;
+	header.settings = settings;
+	header.sampleRate = reader.sampleRate;
+	header.numChannels = 2;
+	header.frames = frames;
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	//a fresh instance per miss renders exactly the defaults plus the overrides the key hashes, whatever
+	//an earlier miss left behind
+	OfflineCore engine;
+	engine.prepare(reader.sampleRate, parameters);
+
+	const uint32_t blockSize = OfflineCore::blockSize;
+	float* in[2] = { &buffer[0], &buffer[blockSize] };
+	float* out[2] = { &buffer[2 * blockSize], &buffer[3 * blockSize] };
+	float* interleaved = &buffer[4 * blockSize];
+
+	uint64_t pos = 0;
+	while (pos < frames && ok)
+	{
+		uint32_t n = frames - pos < blockSize ? (uint32_t)(frames - pos) : blockSize;
+		uint32_t read = reader.readFrames(in, n);
+		for (uint32_t c = 0; c < 2; c++)
+			if (read < n) memset(in[c] + read, 0, (n - read) * sizeof(float));  //the tail runs on silence
+		engine.process(in, out, reader.numChannels, n);
+
+		for (uint32_t i = 0; i < n; i++)
+		{
+			interleaved[2 * i] = out[0][i];
+			interleaved[2 * i + 1] = out[1][i];
+		}
+		ok = fwrite(interleaved, 2 * sizeof(float), n, file) == n;
+		pos += n;
+	}
+
+	ok &= fclose(file) == 0;
+	if (ok && rename(temp.c_str(), path.c_str()) == 0) return true;
+
+	//a failed rename can also mean another worker stored the same key first; the lookup decides
+	remove(temp.c_str());
+	return ok;
+}
+
+bool RenderCache::render(const char* inPath, CachedRender& result)
+{
+	result.map.close();
+	result.samples = nullptr;
+	result.frames = 0;
+	result.sampleRate = 0;
+	result.hit = false;
+
+	WavReader reader;
+	if (!reader.open(inPath) || reader.numChannels == 0 || reader.numChannels > 2) return false;
+
+	uint64_t input;
+	if (!inputHash(reader, input)) return false;
+	uint64_t frames = reader.numFrames + (uint64_t)(tailSeconds * reader.sampleRate);
+	uint64_t settings = settingsHash(reader.sampleRate, frames);
+
+	Fnv1a key;
+	key.add(input);
+	key.add(settings);
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.dtrc", (unsigned long long)key.hash);
+	result.path = directory + "/" + name;
+
+	if (lookup(result.path, input, settings, result))
+	{
+		result.hit = true;
+		return true;
+	}
+
+	return store(result.path, reader, input, settings, frames) && lookup(result.path, input, settings, result);
+}
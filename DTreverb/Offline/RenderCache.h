@@ -0,0 +1,57 @@
+#ifndef RenderCache_h
+#define RenderCache_h
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "BatchRender.h"
+#include "WavFile.h"
+
+//64-bit FNV-1a, fed incrementally
+struct Fnv1a {
+	uint64_t hash = 14695981039346656037ULL;
+	void add(const void* data, size_t size)
+	{
+		const uint8_t* p = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= p[i];
+			hash *= 1099511628211ULL;
+		}
+	}
+	template <class T> void add(const T& value) { add(&value, sizeof(T)); }
+};
+
+//a finished render, mapped straight from the cache file: interleaved stereo float, valid while this object lives
+struct CachedRender {
+	MappedFile map;
+	const float* samples = nullptr;
+	uint64_t frames = 0;
+	uint32_t sampleRate = 0;
+	bool hit = false;    //false: rendered by this call
+	std::string path;
+};
+
+//content-addressed offline renders: the key hashes the decoded input audio, the full parameter
+//snapshot, the sample rate, the tail length and PluginCore::engineVersion. A hit maps the stored
+//result without building or running the DSP, a miss renders through OfflineCore and stores it
+class RenderCache {
+public:
+	RenderCache(const char* _directory);
+
+	bool render(const char* inPath, CachedRender& result);
+
+	std::vector<PresetParameter> parameters;  //settings over the plugin defaults, same as BatchRenderer
+	double tailSeconds;                        //silence rendered after the input
+	std::string directory;
+
+private:
+	bool inputHash(WavReader& reader, uint64_t& hash);
+	uint64_t settingsHash(uint32_t sampleRate, uint64_t frames);
+	bool lookup(const std::string& path, uint64_t input, uint64_t settings, CachedRender& result);
+	bool store(const std::string& path, WavReader& reader, uint64_t input, uint64_t settings, uint64_t frames);
+
+	OfflineCore reference;      //parameter list and defaults for the key, never rendered
+	std::vector<float> buffer;  //in L/R + out L/R + interleaved, blockSize each
+};
+
+#endif
@@ -0,0 +1,285 @@
+#include "SegmentRender.h"
+#include <cmath>
+#include <thread>
+#include <chrono>
+
+SegmentRenderer::SegmentRenderer(int _numThreads)
+{
+	numThreads = _numThreads > 0 ? _numThreads : (int)std::thread::hardware_concurrency();
+	if (numThreads < 1) numThreads = 1;
+	tailSeconds = 0.0;
+	preRollSeconds = 0.0;
+	crossfadeSeconds = 0.05;
+	measureError = false;
+	preRoll = 0;
+	crossfade = 0;
+	rendering = 0;
+}
+
+double SegmentRenderer::estimateTailSeconds(PluginCore& core)
+{
+	//closed form: predelay, diffuser smear and the slowest octave band of the tank or FDN
+	return core.estimateDecay().tail;
+}
+
+bool SegmentRenderer::renderSegment(Segment& segment, const char* inPath, uint64_t inputFrames, uint64_t totalFrames)
+{
+	WavReader reader;
+	if (!reader.open(inPath)) return false;
+
+	OfflineCore engine;
+	engine.prepare(reader.sampleRate, parameters);
+
+	const uint32_t blockSize = OfflineCore::blockSize;
+	std::vector<float> buffer(4 * blockSize);
+	float* in[2] = { &buffer[0], &buffer[blockSize] };
+	float* out[2] = { &buffer[2 * blockSize], &buffer[3 * blockSize] };
+
+	uint64_t pos = segment.start > preRoll ? segment.start - preRoll : 0;
+	uint64_t stop = segment.end + crossfade < totalFrames ? segment.end + crossfade : totalFrames;
+	uint64_t direct = segment.start > 0 ? segment.start + crossfade : 0; //first frame this segment owns outright
+	reader.seek(pos < inputFrames ? pos : inputFrames);
+
+	bool ok = true;
+	while (pos < stop && ok)
+	{
+		uint32_t frames = stop - pos < blockSize ? (uint32_t)(stop - pos) : blockSize;
+		uint32_t n = reader.readFrames(in, frames);
+		for (uint32_t c = 0; c < 2; c++)
+			if (n < frames) memset(in[c] + n, 0, (frames - n) * sizeof(float));
+		engine.process(in, out, reader.numChannels, frames);
+
+		//frames before start are pre-roll and thrown away
+		for (uint32_t i = 0; i < frames; i++)
+		{
+			uint64_t f = pos + i;
+			if (f >= segment.start && f < direct)
+				for (uint32_t c = 0; c < 2; c++) segment.head[c].push_back(out[c][i]);
+			else if (f >= segment.end)
+				for (uint32_t c = 0; c < 2; c++) segment.tail[c].push_back(out[c][i]);
+		}
+
+		uint64_t a = pos > direct ? pos : direct;
+		uint64_t b = pos + frames < segment.end ? pos + frames : segment.end;
+		if (b > a)
+		{
+			float* range[2] = { out[0] + (a - pos), out[1] + (a - pos) };
+			stage(segment, range, a, (uint32_t)(b - a));
+		}
+		pos += frames;
+	}
+	submit(segment);
+	return ok;
+}
+
+void SegmentRenderer::stage(Segment& segment, float** out, uint64_t frame, uint32_t frames)
+{
+	//the owned range is contiguous, a chunk is only started where the previous one ended
+	while (frames > 0)
+	{
+		Chunk& chunk = segment.chunk[segment.front];
+		if (chunk.frames == 0) chunk.frame = frame;
+		uint32_t n = chunkFrames - chunk.frames < frames ? chunkFrames - chunk.frames : frames;
+		for (uint32_t c = 0; c < 2; c++)
+			memcpy(&chunk.data[c][chunk.frames], out[c], n * sizeof(float));
+		chunk.frames += n;
+		if (chunk.frames == chunkFrames) submit(segment);
+
+		out[0] += n;
+		out[1] += n;
+		frame += n;
+		frames -= n;
+	}
+}
+
+void SegmentRenderer::submit(Segment& segment)
+{
+	Chunk& chunk = segment.chunk[segment.front];
+	if (chunk.frames == 0) return;
+
+	std::unique_lock<std::mutex> guard(stageLock);
+	Chunk& back = segment.chunk[1 - segment.front];
+	staged.wait(guard, [&back]() { return !back.queued; });
+	chunk.queued = true;
+	pending.push_back(&chunk);
+	staged.notify_all();
+
+	segment.front = 1 - segment.front;
+	back.frames = 0;
+}
+
+bool SegmentRenderer::writeStaged(WavWriter& writer)
+{
+	bool ok = true;
+	std::unique_lock<std::mutex> guard(stageLock);
+	for (;;)
+	{
+		staged.wait(guard, [this]() { return !pending.empty() || rendering == 0; });
+		if (pending.empty())
+			return ok;
+		Chunk* chunk = pending.front();
+		pending.pop_front();
+		guard.unlock();
+
+		//keep draining after a failure so no segment is left waiting on its back chunk
+		float* range[2] = { &chunk->data[0][0], &chunk->data[1][0] };
+		if (ok) ok = writer.writeFramesAt(chunk->frame, range, chunk->frames);
+
+		guard.lock();
+		chunk->queued = false;
+		staged.notify_all();
+	}
+}
+
+bool SegmentRenderer::compareSerial(const char* inPath, const char* outPath, uint64_t totalFrames, SegmentReport& report)
+{
+	WavReader reader, rendered;
+	if (!reader.open(inPath) || !rendered.open(outPath) || rendered.numFrames != totalFrames) return false;
+
+	auto start = std::chrono::steady_clock::now();
+
+	OfflineCore engine;
+	engine.prepare(reader.sampleRate, parameters);
+
+	const uint32_t blockSize = OfflineCore::blockSize;
+	std::vector<float> buffer(6 * blockSize);
+	float* in[2] = { &buffer[0], &buffer[blockSize] };
+	float* out[2] = { &buffer[2 * blockSize], &buffer[3 * blockSize] };
+	float* seg[2] = { &buffer[4 * blockSize], &buffer[5 * blockSize] };
+
+	double errorEnergy = 0.0;
+	double signalEnergy = 0.0;
+	uint64_t pos = 0;
+	while (pos < totalFrames)
+	{
+		uint32_t frames = totalFrames - pos < blockSize ? (uint32_t)(totalFrames - pos) : blockSize;
+		uint32_t n = reader.readFrames(in, frames);
+		for (uint32_t c = 0; c < 2; c++)
+			if (n < frames) memset(in[c] + n, 0, (frames - n) * sizeof(float));
+		engine.process(in, out, reader.numChannels, frames);
+		rendered.readFrames(seg, frames);
+
+		for (uint32_t c = 0; c < 2; c++)
+		{
+			for (uint32_t i = 0; i < frames; i++)
+			{
+				double e = (double)seg[c][i] - out[c][i];
+				if (fabs(e) > report.maxError) report.maxError = fabs(e);
+				errorEnergy += e * e;
+				signalEnergy += (double)out[c][i] * out[c][i];
+			}
+		}
+		pos += frames;
+	}
+
+	report.serialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (errorEnergy > 0 && signalEnergy > 0) report.rmsErrorDb = 10 * log10(errorEnergy / signalEnergy);
+	return true;
+}
+
+bool SegmentRenderer::render(const char* inPath, const char* outPath, SegmentReport& report)
+{
+	report = SegmentReport();
+
+	WavReader reader;
+	if (!reader.open(inPath) || reader.numChannels == 0 || reader.numChannels > 2) return false;
+	uint64_t inputFrames = reader.numFrames;
+	uint64_t totalFrames = inputFrames + (uint64_t)(tailSeconds * reader.sampleRate);
+	double fs = reader.sampleRate;
+	reader.close();
+
+	double preRollTime = preRollSeconds;
+	if (preRollTime <= 0)
+	{
+		OfflineCore probe;
+		probe.prepare(fs, parameters);
+		preRollTime = estimateTailSeconds(probe.core);
+	}
+	preRoll = (uint64_t)(preRollTime * fs);
+	crossfade = (uint64_t)(crossfadeSeconds * fs);
+
+	//a segment has to be longer than the crossfade on both of its ends
+	int segments = numThreads;
+	while (segments > 1 && totalFrames / segments < 2 * crossfade + 1) segments--;
+
+	WavWriter writer;
+	if (!writer.open(outPath, 2, (uint32_t)fs)) return false;
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<Segment> parts(segments);
+	for (int k = 0; k < segments; k++)
+	{
+		parts[k].start = totalFrames * k / segments;
+		parts[k].end = totalFrames * (k + 1) / segments;
+		parts[k].front = 0;
+		parts[k].ok = false;
+		for (int j = 0; j < 2; j++)
+		{
+			parts[k].chunk[j].frame = 0;
+			parts[k].chunk[j].frames = 0;
+			parts[k].chunk[j].queued = false;
+			for (uint32_t c = 0; c < 2; c++)
+				parts[k].chunk[j].data[c].resize(chunkFrames);
+		}
+	}
+
+	//segments render in parallel, this thread is the only one touching the file
+	rendering = segments;
+	std::vector<std::thread> threads;
+	for (int k = 0; k < segments; k++)
+		threads.push_back(std::thread([this, k, &parts, inPath, inputFrames, totalFrames]()
+		{
+			parts[k].ok = renderSegment(parts[k], inPath, inputFrames, totalFrames);
+			std::lock_guard<std::mutex> guard(stageLock);
+			rendering--;
+			staged.notify_all();
+		}));
+	bool ok = writeStaged(writer);
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	//equal-gain crossfade: both sides carry the same, nearly identical, signal
+	std::vector<float> blend[2];
+	for (int k = 0; k < segments; k++)
+	{
+		ok &= parts[k].ok;
+		if (k == 0 || !ok) continue;
+
+		size_t length = parts[k].head[0].size();
+		for (uint32_t c = 0; c < 2; c++)
+		{
+			blend[c].resize(length);
+			for (size_t i = 0; i < length; i++)
+			{
+				double w = (i + 0.5) / length;
+				blend[c][i] = (float)(parts[k - 1].tail[c][i] * (1 - w) + parts[k].head[c][i] * w);
+			}
+		}
+		float* range[2] = { &blend[0][0], &blend[1][0] };
+		if (length > 0) ok &= writer.writeFramesAt(parts[k].start, range, (uint32_t)length);
+	}
+	ok &= writer.close();
+
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	report.segments = segments;
+	report.frames = totalFrames;
+	report.preRollFrames = preRoll;
+	report.crossfadeFrames = crossfade;
+
+	if (ok && measureError)
+		ok = compareSerial(inPath, outPath, totalFrames, report);
+
+	report.ok = ok;
+	return ok;
+}
+
+void SegmentRenderer::printReport(const SegmentReport& report, FILE* out)
+{
+	fprintf(out, "%s: %d segments, %llu frames, pre-roll %llu, crossfade %llu, %.3f s\n", report.ok ? "ok" : "FAILED",
+		report.segments, (unsigned long long)report.frames, (unsigned long long)report.preRollFrames,
+		(unsigned long long)report.crossfadeFrames, report.seconds);
+	if (report.serialSeconds > 0)
+		fprintf(out, "serial %.3f s (%.1fx speedup), max error %.3g, rms error %.1f dB\n", report.serialSeconds,
+			report.seconds > 0 ? report.serialSeconds / report.seconds : 0.0, report.maxError, report.rmsErrorDb);
+}
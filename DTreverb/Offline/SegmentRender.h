@@ -0,0 +1,77 @@
+#ifndef SegmentRender_h
+#define SegmentRender_h
+#include <stdio.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include "BatchRender.h"
+#include "WavFile.h"
+
+//what a segmented render did, and how far it is from a straight serial render
+struct SegmentReport {
+	bool ok = false;
+	int segments = 0;
+	uint64_t frames = 0;
+	uint64_t preRollFrames = 0;
+	uint64_t crossfadeFrames = 0;
+	double seconds = 0.0;        //parallel render wall time
+	double serialSeconds = 0.0;  //only when measureError is set
+	double maxError = 0.0;       //largest absolute sample difference against the serial render
+	double rmsErrorDb = -200.0;  //error RMS relative to the serial render RMS
+};
+
+//renders one long file as parallel segments: each segment warms its own tank on a pre-roll window
+//as long as the reverb tail, discards it, and the segments are joined with short crossfades
+class SegmentRenderer {
+public:
+	SegmentRenderer(int _numThreads = 0);  //0 = one segment per hardware thread
+
+	bool render(const char* inPath, const char* outPath, SegmentReport& report);
+	void printReport(const SegmentReport& report, FILE* out = stdout);
+
+	static double estimateTailSeconds(PluginCore& core);  //time for the tank to fall 60 dB at the current settings
+
+	std::vector<PresetParameter> parameters;
+	double tailSeconds;       //silence rendered after the input
+	double preRollSeconds;    //<= 0: use estimateTailSeconds
+	double crossfadeSeconds;
+	bool measureError;        //also render serially and compare
+	int numThreads;
+
+private:
+	//owned output is staged here; a segment fills one chunk while the other waits for the writer
+	struct Chunk {
+		uint64_t frame;
+		uint32_t frames;
+		bool queued;
+		std::vector<float> data[2];
+	};
+
+	struct Segment {
+		uint64_t start;
+		uint64_t end;
+		std::vector<float> head[2];  //first crossfade frames, blended with the previous segment's overrun
+		std::vector<float> tail[2];  //crossfade frames rendered past end
+		Chunk chunk[2];
+		int front;
+		bool ok;
+	};
+
+	bool renderSegment(Segment& segment, const char* inPath, uint64_t inputFrames, uint64_t totalFrames);
+	void stage(Segment& segment, float** out, uint64_t frame, uint32_t frames);
+	void submit(Segment& segment);        //queue the front chunk, waits only if the back one is still on its way to disk
+	bool writeStaged(WavWriter& writer);  //the only thread that writes: positioned writes until every segment is done
+	bool compareSerial(const char* inPath, const char* outPath, uint64_t totalFrames, SegmentReport& report);
+
+	uint64_t preRoll;
+	uint64_t crossfade;
+
+	std::mutex stageLock;
+	std::condition_variable staged;
+	std::deque<Chunk*> pending;
+	int rendering;  //segments still running
+	static const uint32_t chunkFrames = 65536;
+};
+
+#endif
@@ -0,0 +1,336 @@
+#include "WavFile.h"
+
+//little-endian helpers, WAV is always little-endian
+static uint32_t readLE32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t readLE16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint64_t readLE64(const uint8_t* p) { return readLE32(p) | ((uint64_t)readLE32(p + 4) << 32); }
+static void writeLE32(uint8_t* p, uint32_t v) { p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; p[2] = (v >> 16) & 0xff; p[3] = (v >> 24) & 0xff; }
+static void writeLE16(uint8_t* p, uint16_t v) { p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; }
+static void writeLE64(uint8_t* p, uint64_t v) { writeLE32(p, (uint32_t)v); writeLE32(p + 4, (uint32_t)(v >> 32)); }
+
+//writer header layout: RIFF, JUNK (reserved for ds64), fmt, data
+static const int kJunkOffset = 12;
+static const int kDs64Size = 28;
+static const int kFmtOffset = kJunkOffset + 8 + kDs64Size;
+static const int kDataOffset = kFmtOffset + 8 + 16;
+static const int kHeaderSize = kDataOffset + 8;
+
+//fseek only takes a long, which is 32 bits on Windows
+static bool seek64(FILE* file, uint64_t offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+	return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+WavReader::WavReader()
+{
+	numChannels = 0;
+	sampleRate = 0;
+	bitsPerSample = 0;
+	numFrames = 0;
+	isFloat = false;
+	dataOffset = 0;
+	position = 0;
+	released = 0;
+}
+
+WavReader::~WavReader()
+{
+	close();
+}
+
+bool WavReader::open(const char* path)
+{
+	close();
+	if (!map.open(path) || map.size < 12) { close(); return false; }
+
+	const uint8_t* p = map.data;
+	bool rf64 = memcmp(p, "RF64", 4) == 0;
+	if ((!rf64 && memcmp(p, "RIFF", 4) != 0) || memcmp(p + 8, "WAVE", 4) != 0) { close(); return false; }
+
+	bool haveFormat = false;
+	uint64_t ds64DataSize = 0;
+	uint64_t offset = 12;
+	while (offset + 8 <= map.size)
+	{
+		const uint8_t* chunk = p + offset;
+		uint64_t chunkSize = readLE32(chunk + 4);
+		const uint8_t* body = chunk + 8;
+		offset += 8;
+
+		if (memcmp(chunk, "ds64", 4) == 0 && chunkSize >= 24 && offset + 24 <= map.size)
+			ds64DataSize = readLE64(body + 8);  //64-bit RIFF size, then data size, then sample count
+		else if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && offset + chunkSize <= map.size)
+		{
+			uint16_t formatTag = readLE16(body);
+			numChannels = readLE16(body + 2);
+			sampleRate = readLE32(body + 4);
+			bitsPerSample = readLE16(body + 14);
+			if (formatTag == 0xFFFE && chunkSize >= 26) formatTag = readLE16(body + 24); //WAVE_FORMAT_EXTENSIBLE, subformat GUID starts with the tag
+			isFloat = (formatTag == 3);
+			haveFormat = (formatTag == 1 || formatTag == 3);
+		}
+		else if (memcmp(chunk, "data", 4) == 0)
+		{
+			//8/16/24/32-bit PCM and 32/64-bit float; anything else would read as silence, so it is refused
+			bool supported = isFloat ? (bitsPerSample == 32 || bitsPerSample == 64) :
+				(bitsPerSample == 8 || bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32);
+			if (!haveFormat || numChannels == 0 || !supported) break;
+			if (rf64 && chunkSize == 0xFFFFFFFF) chunkSize = ds64DataSize;
+			if (offset + chunkSize > map.size) chunkSize = map.size - offset; //truncated file, play what is there
+			dataOffset = offset;
+			numFrames = chunkSize / (numChannels * (bitsPerSample / 8));
+			position = 0;
+			released = 0;
+			map.sequential();
+			return true;
+		}
+		offset += chunkSize + (chunkSize & 1); //chunks are word aligned
+	}
+
+	close();
+	return false;
+}
+
+void WavReader::close()
+{
+	map.close();
+	numFrames = 0;
+	position = 0;
+}
+
+bool WavReader::rewind()
+{
+	return seek(0);
+}
+
+bool WavReader::seek(uint64_t frame)
+{
+	if (!map.data || frame > numFrames) return false;
+	position = frame;
+	released = 0;
+	return true;
+}
+
+uint32_t WavReader::readFrames(float** channels, uint32_t maxFrames)
+{
+	if (!map.data || position >= numFrames) return 0;
+
+	uint32_t bytesPerSample = bitsPerSample / 8;
+	uint64_t frameBytes = (uint64_t)numChannels * bytesPerSample;
+	uint64_t remaining = numFrames - position;
+	uint32_t frames = remaining < maxFrames ? (uint32_t)remaining : maxFrames;
+
+	const uint8_t* p = map.data + dataOffset + position * frameBytes;
+	for (uint32_t c = 0; c < numChannels; c++)
+	{
+		const uint8_t* s = p + c * bytesPerSample;
+		float* out = channels[c];
+		if (isFloat && bitsPerSample == 32)
+			for (uint32_t i = 0; i < frames; i++, s += frameBytes) memcpy(&out[i], s, 4);
+		else if (isFloat)
+			for (uint32_t i = 0; i < frames; i++, s += frameBytes) { double d; memcpy(&d, s, 8); out[i] = (float)d; }
+		else if (bitsPerSample == 8)
+			for (uint32_t i = 0; i < frames; i++, s += frameBytes) out[i] = ((int)s[0] - 128) / 128.f;  //8-bit PCM is unsigned
+		else if (bitsPerSample == 16)
+			for (uint32_t i = 0; i < frames; i++, s += frameBytes) out[i] = (int16_t)readLE16(s) / 32768.f;
+		else if (bitsPerSample == 24)
+			for (uint32_t i = 0; i < frames; i++, s += frameBytes) out[i] = ((int32_t)((s[0] << 8) | (s[1] << 16) | ((uint32_t)s[2] << 24)) >> 8) / 8388608.f;
+		else
+			for (uint32_t i = 0; i < frames; i++, s += frameBytes) out[i] = (int32_t)readLE32(s) / 2147483648.f;
+	}
+	position += frames;
+
+	//give back what is behind us in 4 MB steps
+	uint64_t consumed = position * frameBytes;
+	if (consumed - released >= (4 << 20))
+	{
+		map.release(dataOffset + released, consumed - released);
+		released = consumed;
+	}
+	return frames;
+}
+
+WavWriter::WavWriter()
+{
+	file = nullptr;
+	numChannels = 0;
+	sampleRate = 0;
+	framesWritten = 0;
+	bufferFrames = 0;
+	fill = 0;
+	front = 0;
+	pendingFrames = 0;
+	quit = false;
+	failed = false;
+}
+
+WavWriter::~WavWriter()
+{
+	close();
+}
+
+bool WavWriter::open(const char* path, uint32_t _numChannels, uint32_t _sampleRate, uint32_t _bufferFrames)
+{
+	close();
+	file = fopen(path, "wb");
+	if (!file) return false;
+
+	numChannels = _numChannels;
+	sampleRate = _sampleRate;
+	bufferFrames = _bufferFrames;
+	framesWritten = 0;
+	fill = 0;
+	front = 0;
+	pendingFrames = 0;
+	quit = false;
+	failed = false;
+	buffer[0].resize((size_t)bufferFrames * numChannels);
+	buffer[1].resize((size_t)bufferFrames * numChannels);
+
+	//sizes are patched in close(); the JUNK chunk is where a ds64 goes if the file needs RF64
+	uint8_t header[kHeaderSize] = { 0 };
+	memcpy(header, "RIFF", 4);
+	memcpy(header + 8, "WAVE", 4);
+	memcpy(header + kJunkOffset, "JUNK", 4);
+	writeLE32(header + kJunkOffset + 4, kDs64Size);
+	memcpy(header + kFmtOffset, "fmt ", 4);
+	writeLE32(header + kFmtOffset + 4, 16);
+	writeLE16(header + kFmtOffset + 8, 3); //IEEE float
+	writeLE16(header + kFmtOffset + 10, (uint16_t)numChannels);
+	writeLE32(header + kFmtOffset + 12, sampleRate);
+	writeLE32(header + kFmtOffset + 16, sampleRate * numChannels * 4);
+	writeLE16(header + kFmtOffset + 20, (uint16_t)(numChannels * 4));
+	writeLE16(header + kFmtOffset + 22, 32);
+	memcpy(header + kDataOffset, "data", 4);
+	if (fwrite(header, 1, kHeaderSize, file) != kHeaderSize)
+	{
+		fclose(file);
+		file = nullptr;
+		return false;
+	}
+
+	writer = std::thread(&WavWriter::writerThread, this);
+	return true;
+}
+
+void WavWriter::writerThread()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	while (true)
+	{
+		signal.wait(guard, [this]() { return pendingFrames > 0 || quit; });
+		if (pendingFrames == 0 && quit) return;
+
+		//the back buffer belongs to this thread until pendingFrames goes back to 0
+		const std::vector<float>& back = buffer[1 - front];
+		size_t count = (size_t)pendingFrames * numChannels;
+		guard.unlock();
+		bool ok = fwrite(&back[0], sizeof(float), count, file) == count;
+		guard.lock();
+
+		if (!ok) failed = true;
+		pendingFrames = 0;
+		signal.notify_all();
+	}
+}
+
+bool WavWriter::swapBuffers()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	signal.wait(guard, [this]() { return pendingFrames == 0; });
+	front = 1 - front;
+	pendingFrames = fill;
+	fill = 0;
+	signal.notify_all();
+	return !failed;
+}
+
+bool WavWriter::writeFrames(float** channels, uint32_t frames)
+{
+	if (!file) return false;
+
+	bool ok = true;
+	uint32_t done = 0;
+	while (done < frames)
+	{
+		uint32_t count = frames - done;
+		if (count > bufferFrames - fill) count = bufferFrames - fill;
+
+		float* p = &buffer[front][(size_t)fill * numChannels];
+		for (uint32_t i = done; i < done + count; i++)
+			for (uint32_t c = 0; c < numChannels; c++)
+				*p++ = channels[c][i];
+
+		fill += count;
+		done += count;
+		if (fill == bufferFrames) ok &= swapBuffers();
+	}
+
+	framesWritten += frames;
+	return ok;
+}
+
+bool WavWriter::writeFramesAt(uint64_t frame, float** channels, uint32_t frames)
+{
+	if (!file) return false;
+
+	std::lock_guard<std::mutex> guard(lock);
+	size_t count = (size_t)frames * numChannels;
+	if (scratch.size() < count) scratch.resize(count);
+
+	float* p = &scratch[0];
+	for (uint32_t i = 0; i < frames; i++)
+		for (uint32_t c = 0; c < numChannels; c++)
+			*p++ = channels[c][i];
+
+	if (frame + frames > framesWritten) framesWritten = frame + frames;
+	return seek64(file, kHeaderSize + frame * numChannels * 4) && fwrite(&scratch[0], sizeof(float), count, file) == count;
+}
+
+bool WavWriter::close()
+{
+	if (!file) return true;
+
+	bool ok = true;
+	if (fill > 0) ok &= swapBuffers();
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+		signal.notify_all();
+	}
+	writer.join();
+	ok &= !failed;
+
+	uint64_t dataBytes = framesWritten * numChannels * 4;
+	uint64_t riffBytes = dataBytes + kHeaderSize - 8;
+	uint8_t header[kHeaderSize];
+
+	//rebuild the fixed part of the header with the final sizes
+	memcpy(header, "RIFF", 4);
+	writeLE32(header + 4, (uint32_t)riffBytes);
+	memcpy(header + 8, "WAVE", 4);
+	memcpy(header + kJunkOffset, "JUNK", 4);
+	writeLE32(header + kJunkOffset + 4, kDs64Size);
+	memset(header + kJunkOffset + 8, 0, kDs64Size);
+	if (riffBytes > 0xFFFFFFFF)
+	{
+		memcpy(header, "RF64", 4);
+		writeLE32(header + 4, 0xFFFFFFFF);
+		memcpy(header + kJunkOffset, "ds64", 4);
+		writeLE64(header + kJunkOffset + 8, riffBytes);
+		writeLE64(header + kJunkOffset + 16, dataBytes);
+		writeLE64(header + kJunkOffset + 24, framesWritten);
+	}
+	ok &= fseek(file, 0, SEEK_SET) == 0 && fwrite(header, 1, kFmtOffset, file) == (size_t)kFmtOffset;
+
+	writeLE32(header, dataBytes > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)dataBytes);
+	ok &= fseek(file, kDataOffset + 4, SEEK_SET) == 0 && fwrite(header, 1, 4, file) == 4;
+
+	ok &= fclose(file) == 0;
+	file = nullptr;
+	return ok;
+}
@@ -0,0 +1,76 @@
+#ifndef WavFile_h
+#define WavFile_h
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "MappedFile.h"
+
+//WAV/RF64 reader over a memory map; converts one block at a time into the float** arrays.
+//8/16/24/32-bit PCM and 32/64-bit float, open() refuses every other format
+//ProcessBufferInfo expects, and releases the pages behind the read position so resident
+//memory stays constant for any file length
+class WavReader {
+public:
+	WavReader();
+	~WavReader();
+
+	bool open(const char* path);
+	void close();
+	uint32_t readFrames(float** channels, uint32_t maxFrames); //deinterleaves into channel arrays, returns frames read
+	bool rewind();
+	bool seek(uint64_t frame);
+
+	uint32_t numChannels;
+	uint32_t sampleRate;
+	uint32_t bitsPerSample;
+	uint64_t numFrames;
+	bool isFloat;
+
+private:
+	MappedFile map;
+	uint64_t dataOffset;
+	uint64_t position;  //next frame to read
+	uint64_t released;  //bytes of audio data already handed back to the OS
+};
+
+//32-bit float WAV writer with a double-buffered background thread: the caller only copies
+//into the front buffer, the disk write of the back buffer happens on the writer thread.
+//Files that outgrow 4 GB are promoted to RF64 on close
+class WavWriter {
+public:
+	WavWriter();
+	~WavWriter();
+
+	bool open(const char* path, uint32_t _numChannels, uint32_t _sampleRate, uint32_t _bufferFrames = 65536);
+	bool writeFrames(float** channels, uint32_t frames);
+	bool writeFramesAt(uint64_t frame, float** channels, uint32_t frames); //random access for renderers that finish out of order; do not mix with writeFrames
+	bool close();
+
+	uint32_t numChannels;
+	uint32_t sampleRate;
+	uint64_t framesWritten;
+
+private:
+	void writerThread();
+	bool swapBuffers();  //hand the front buffer to the writer, waits only if the disk is a full buffer behind
+
+	FILE* file;
+	std::vector<float> buffer[2];
+	std::vector<float> scratch;  //writeFramesAt interleave buffer
+	uint32_t bufferFrames;
+	uint32_t fill;       //frames in the front buffer
+	int front;
+
+	std::thread writer;
+	std::mutex lock;
+	std::condition_variable signal;
+	uint32_t pendingFrames;  //frames in the back buffer waiting for the writer, 0 = back buffer free
+	bool quit;
+	bool failed;
+};
+
+#endif
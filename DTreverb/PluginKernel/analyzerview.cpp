@@ -0,0 +1,103 @@
+#include "analyzerview.h"
+#include <string.h>
+#include <stdio.h>
+
+namespace VSTGUI {
+
+DecayAnalyzerView::DecayAnalyzerView(const CRect& size, IControlListener* listener, int32_t tag)
+: CView(size)
+{
+	memset(&frame, 0, sizeof(frame));
+	frame.fitindex = -1;
+	for (int i = 0; i < AnalyzerFrame::bands; i++) frame.spectrum[i] = (float)floorDb;
+	for (int i = 0; i < AnalyzerFrame::points; i++) frame.decay[i] = (float)floorDb;
+}
+
+void DecayAnalyzerView::updateView()
+{
+	if (!fresh) return;
+	fresh = false;
+	invalid();
+}
+
+void DecayAnalyzerView::sendMessage(void* data)
+{
+	if (!data) return;
+	frame = *(AnalyzerFrame*)data;
+	fresh = true;
+}
+
+double DecayAnalyzerView::levelToY(const CRect& area, double dB)
+{
+	if (dB < floorDb) dB = floorDb;
+	if (dB > 0.0) dB = 0.0;
+	return area.top + area.getHeight() * (dB / floorDb);
+}
+
+void DecayAnalyzerView::plot(CDrawContext* context, const CRect& area, const float* values, int count)
+{
+	double step = area.getWidth() / (count - 1);
+	CPoint last(area.left, levelToY(area, values[0]));
+	for (int i = 1; i < count; i++)
+	{
+		CPoint next(area.left + i * step, levelToY(area, values[i]));
+		context->drawLine(last, next);
+		last = next;
+	}
+}
+
+void DecayAnalyzerView::draw(CDrawContext* context)
+{
+	const CRect& size = getViewSize();
+	context->setDrawMode(kAntiAliasing);
+	context->setFillColor(kBlackCColor);
+	context->drawRect(size, kDrawFilled);
+
+	// --- spectrum above, decay history below
+	CRect top(size.left, size.top, size.right, size.top + size.getHeight() * 0.55);
+	CRect bottom(size.left, top.bottom + 4, size.right, size.bottom);
+
+	context->setLineWidth(1);
+	context->setFrameColor(CColor(60, 60, 60, 255));
+	for (double dB = -20.0; dB > floorDb; dB -= 20.0)
+	{
+		context->drawLine(CPoint(top.left, levelToY(top, dB)), CPoint(top.right, levelToY(top, dB)));
+		context->drawLine(CPoint(bottom.left, levelToY(bottom, dB)), CPoint(bottom.right, levelToY(bottom, dB)));
+	}
+
+	context->setFrameColor(CColor(0, 200, 255, 255));
+	plot(context, top, frame.spectrum, AnalyzerFrame::bands);
+
+	context->setFrameColor(CColor(255, 180, 0, 255));
+	plot(context, bottom, frame.decay, AnalyzerFrame::points);
+
+	// --- fitted decay, drawn until it leaves the plot
+	if (frame.fitindex >= 0)
+	{
+		double step = bottom.getWidth() / (AnalyzerFrame::points - 1);
+		double frames = (floorDb - frame.fitstart) / (frame.fitslope * 0.01);
+		double end = frame.fitindex + frames < AnalyzerFrame::points - 1 ? frame.fitindex + frames : AnalyzerFrame::points - 1;
+		context->setFrameColor(CColor(255, 60, 60, 255));
+		context->drawLine(CPoint(bottom.left + frame.fitindex * step, levelToY(bottom, frame.fitstart)),
+			CPoint(bottom.left + end * step, levelToY(bottom, frame.fitstart + frame.fitslope * (end - frame.fitindex) * 0.01)));
+	}
+
+	// --- measured next to the closed form value of the current settings
+	char text[64];
+	char estimate[24];
+	if (frame.estimate >= 0)
+		snprintf(estimate, sizeof(estimate), "%.2f s", frame.estimate);
+	else
+		snprintf(estimate, sizeof(estimate), "inf");
+	if (frame.rt60 > 0)
+		snprintf(text, sizeof(text), "RT60 %.2f s (settings %s)", frame.rt60, estimate);
+	else
+		snprintf(text, sizeof(text), "RT60 -- (settings %s)", estimate);
+	context->setFont(kNormalFontSmall);
+	context->setFontColor(kWhiteCColor);
+	context->drawString(text, CRect(bottom.left, bottom.top, bottom.right - 4, bottom.top + 14), kRightText);
+
+	setDirty(false);
+}
+
+}
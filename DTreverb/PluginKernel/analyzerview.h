@@ -0,0 +1,58 @@
+// -----------------------------------------------------------------------------
+//    DTreverb custom view:  analyzerview.h
+//
+/**
+    \file   analyzerview.h
+    \brief  wet spectrum and live decay view, fed by PluginCore's DecayAnalyzer
+*/
+// -----------------------------------------------------------------------------
+#pragma once
+#ifndef __analyzerview_h__
+#define __analyzerview_h__
+
+#include "vstgui/vstgui.h"
+#include "pluginstructures.h"
+#include "..\DTreverb\win_build\COMMON\DecayAnalyzer.h"
+
+namespace VSTGUI {
+
+/**
+\class DecayAnalyzerView
+\ingroup Custom-Views
+\brief
+Spectrum of the wet signal on top, its 10 ms energy history below with the fitted decay line and the
+measured RT60.
+
+Operation:
+- PluginCore registers it under the custom view name "DecayAnalyzerView"
+- on every GUI timer ping the core passes the newest AnalyzerFrame through sendMessage( ) and calls
+  updateView( ); both run on the GUI thread, so the frame is simply copied
+- all analysis runs on the DecayAnalyzer worker thread, the view only draws
+*/
+class DecayAnalyzerView : public CView, public ICustomView
+{
+public:
+	DecayAnalyzerView(const CRect& size, IControlListener* listener, int32_t tag);
+
+	/** ICustomView: repaint if a new frame arrived */
+	virtual void updateView() override;
+
+	/** ICustomView: data is an AnalyzerFrame* owned by the core */
+	virtual void sendMessage(void* data) override;
+
+	/** draw spectrum, decay history, fit line and RT60 */
+	virtual void draw(CDrawContext* context) override;
+
+	static constexpr double floorDb = -90.0;	///< bottom of both plots
+
+protected:
+	void plot(CDrawContext* context, const CRect& area, const float* values, int count);
+	double levelToY(const CRect& area, double dB);
+
+	AnalyzerFrame frame;
+	bool fresh = false;
+};
+
+}
+
+#endif
@@ -14,17 +14,60 @@
 #define __pluginCore_h__
 
 #include "pluginbase.h"
+#include "..\DTreverb\win_build\COMMON\DTMath.h"
 #include "..\DTreverb\win_build\COMMON\allp.h"
 #include "..\DTreverb\win_build\COMMON\DelayLine.h"
 #include "..\DTreverb\win_build\COMMON\LPF.h"
-#include "..\DTreverb\win_build\COMMON\mAllp.h"
-#include "..\DTreverb\win_build\COMMON\TLPF.h"
 #include "..\DTreverb\win_build\COMMON\Dezip.h"
+#include "..\DTreverb\win_build\COMMON\State.h"
+#include "..\DTreverb\win_build\COMMON\StereoDiffuser.h"
+#include "..\DTreverb\win_build\COMMON\TapMatrix.h"
+#include "..\DTreverb\win_build\COMMON\FDN.h"
+#include "..\DTreverb\win_build\COMMON\Dattorro.h"
+#include "..\DTreverb\win_build\COMMON\Convolver.h"
+#include "..\DTreverb\win_build\COMMON\EarlyReflections.h"
+#include "..\DTreverb\win_build\COMMON\Profile.h"
+#include "..\DTreverb\win_build\COMMON\DeadlineMonitor.h"
+#include "..\DTreverb\win_build\COMMON\LevelMeter.h"
+#include "..\DTreverb\win_build\COMMON\DecayAnalyzer.h"
+#include "..\DTreverb\win_build\COMMON\DecayEstimator.h"
+#include "..\DTreverb\win_build\COMMON\PresetBank.h"
+#include "..\DTreverb\win_build\COMMON\Coefficients.h"
 // **--0x7F1F--**
 
 
 // **--0x0F1F--**
-enum controlID {gain, predelaytime,decayfactor,cutoff,damping,diffusion,wetdry};
+enum controlID {gain, predelaytime,decayfactor,cutoff,damping,diffusion,wetdry,freeze,stereomode,algorithm,fdnmatrix,engine,earlylevel,processing,modulation,oversampling,nearmiss,loadp50,loadp99,loadmax,nearmissrate,meterinL,meterinR,meterwetL,meterwetR,metertankL,metertankR,presetfade};
+
+//one algorithmic wet path. PluginCore keeps two: a preset switch starts the new settings on the silent
+//one while the other rings out with the settings it was last cooked with
+struct WetPath {
+	delayline predelay;
+	LowpassFilter lpf1;
+	allp apf1;
+	allp apf2;
+	allp apf3;
+	allp apf4;
+	StereoDiffuser stereoDiffuser;	//true stereo replacement for predelay, lpf1 and apf1-4
+	EarlyReflections early;	//sparse taps beside the tank, faded out as the tank comes in
+	DattorroTank<DattorroTopology> tank;	//figure of eight and output taps
+	FDN fdn;	//replaces the tank when algorithm is not 0
+	int algorithm = 0;	//routing of the path while it rings out
+	bool stereo = false;	//fed by the stereo diffuser
+	enum { objects = 10 };
+	void clear(int k);	//zero object k, a retired path is cleared one object per buffer
+};
+
+//one parameter of a preset morph, resolved when the two ends are set
+struct MorphRange {
+	int32_t index;	//in the parameter list
+	uint32_t controlID;
+	double from;
+	double to;
+	double fromnorm;	//from and to through the control's taper
+	double tonorm;
+};
+
 /**
 \class PluginCore
 \ingroup ASPiK-Core
@@ -70,9 +113,8 @@ public:
 	/** process frames of data */
 	virtual bool processAudioFrame(ProcessFrameInfo& processFrameInfo);
 
-	// --- uncomment and override this for buffer processing; see base class implementation for
-	//     help on breaking up buffers and getting info from processBufferInfo
-	//virtual bool processAudioBuffers(ProcessBufferInfo& processBufferInfo);
+	/** process buffers: mono or stereo in, stereo out straight from the host buffers; everything else as frames; timed for the deadline meters */
+	virtual bool processAudioBuffers(ProcessBufferInfo& processBufferInfo);
 
 	/** preProcess: do any post-buffer processing required; default operation is to send metering data to GUI  */
 	virtual bool postProcessAudioBuffers(ProcessBufferInfo& processInfo);
@@ -105,6 +147,53 @@ public:
 	//	   Add your variables and methods here
 	double gainlin = 1.000000;
 
+	/** size in bytes of a DSP state snapshot at the current sample rate */
+	size_t getStateSize();
+
+	/** write the full DSP state (ring buffers, indices, filter memories, tank feedback) into data */
+	bool saveState(char* data, size_t size);
+
+	/** restore a snapshot into the already allocated buffers; fails if it was taken at another sample rate */
+	bool restoreState(const char* data, size_t size);
+
+	/** render the wet impulse response of the current settings on a private copy of the plugin; any thread */
+	bool captureImpulseResponse(double sampleRate, std::vector<float>& left, std::vector<float>& right);
+
+	/** offline rendering: the convolution engine captures and runs its tail on the calling thread */
+	void setOfflineRendering(bool offline);
+
+	/** bump whenever a change alters rendered output; part of the offline render cache key */
+	static const uint32_t engineVersion = 1;
+
+	/** closed form RT60 and tail of the current settings; audio thread, or any thread while the core is idle */
+	DecayEstimator estimateDecay();
+
+	/** GUI thread: the newest count meter blocks (LevelMeter::block frames each) drained on the timer, oldest first */
+	int getMeterHistory(MeterFrame* out, int count);
+
+	/** write the presets from initPluginPresets( ) as a binary bank */
+	bool savePresetBank(const char* path);
+
+	/** map a binary bank in place of the previous one; presets are read from the map when used. GUI thread */
+	bool loadPresetBank(const char* path);
+
+	/** size and names of the mapped bank; GUI thread */
+	uint32_t getBankPresetCount();
+	const char* getBankPresetName(uint32_t index);
+
+	/** set every parameter stored with a bank preset and tell the GUI and host; GUI thread */
+	bool applyBankPreset(uint32_t index);
+
+	/** set the two ends of a preset morph; a parameter stored in only one of them morphs from or to its default. GUI thread */
+	bool setMorphPresets(const PresetInfo& from, const PresetInfo& to);
+
+	/** move the morph, 0 = from, 1 = to, along each control's taper; the costly coefficients are cooked here for the audio thread. GUI thread */
+	bool setMorph(double amount);
+
+#ifdef DTREVERB_PROFILE
+	/** per-stage cycle histograms of the algorithmic path as text, optionally starting them over; any thread */
+	std::string profileReport(bool clear = false);
+#endif
 
 	// --- END USER VARIABLES AND FUNCTIONS -------------------------------------- //
 
@@ -118,48 +207,86 @@ private:
 	double damping = 0.500000;
 	double diffusion = 0.500000;
 	double wetdry = 1.000000;
+	int freeze = 0;
+	int stereomode = 0;	//0 = inputs summed to mono before the diffuser, 1 = one diffuser chain per input
+	int algorithm = 0;	//0 = Dattorro tank, 1-3 = FDN with 4, 8 or 16 lines
+	int fdnmatrix = 0;
+	int engine = 0;	//0 = algorithmic, 1 = convolution with the captured impulse response
+	double earlylevel = 0.000000;	//early reflections in % of the wet level, 0 = off
+	int processing = 0;	//0 = low latency, 1 = buffered: larger convolution blocks, reported latency and a delayed dry path
+	double modulation = 0.000000;	//tank input allpass modulation in % of Dattorro's excursion
+	int oversampling = 0;	//0 = off, 1 = 2x, 2 = 4x for the modulated allpasses only
+	double nearmiss = 80.000000;	//buffer load in % of the deadline that counts as a near miss
+	float loadp50 = 0.f;	//deadline meters, copied from the monitor before every meter update
+	float loadp99 = 0.f;
+	float loadmax = 0.f;
+	float nearmissrate = 0.f;
+	float meterinL = 0.f;	//level meters: highest block peak since the last buffer
+	float meterinR = 0.f;
+	float meterwetL = 0.f;
+	float meterwetR = 0.f;
+	float metertankL = 0.f;
+	float metertankR = 0.f;
+	double presetfade = 1000.000000;	//crossfade in ms from the old wet path to the new one on a preset switch, 0 = jump in place
 	
 	
-	//double leftTankout;
-	//double rightTankout;
-
-	//name separately for the main audio processing
-	allp apf1;
-	allp apf2;
-	allp apf3;
-	allp apf4;
-	allp apf5;
-	allp apf6;
-
-	delayline delay1;
-	delayline delay2;
-	delayline delay3;
-	delayline delay4;
+	template <class Visitor> void visitState(Visitor& visitor);
+
+	double inputDiffuser(WetPath& w, double input);
+	void stereoInput(double inL, double inR, double& decorL, double& decorR);
+	void processTank(double decorL, double decorR, double& reverb_L, double& reverb_R);
+	void addEarlyReflections(double input, double& reverb_L, double& reverb_R);
+	bool presetSwitch();
+	void switchWetPath();
+	void crossfadeTail(double& reverb_L, double& reverb_R);
+	void cancelFade();
+	void processStereoFrame(double inL, double inR, bool stereoIn, double gainlinDZ, double& outputL, double& outputR);
+	bool processHostBuffers(ProcessBufferInfo& processBufferInfo);
+	void notifyLatency();
+	DecaySettings decaySettings();
+
+	WetPath path[2];	//preallocated, path[livePath] gets the input and the parameters
+	int livePath = 0;
 	double DF = 0.5;
 
-	LowpassFilter lpf1;
-	TLowpassFilter lpf2;
-	TLowpassFilter lpf3;
-
-	MAllp mallp1;
-	MAllp mallp2;
-
-	delayline predelay;
-
-	delayline outdelay1;
-	delayline outdelay2;
-	delayline outdelay3;
-	delayline outdelay4;
-	delayline outdelay5;
-	delayline outdelay6;
-	delayline outdelay7;
-	delayline outdelay8;
-	delayline outdelay9;
-	delayline outdelay10;
-	delayline outdelay11;
-	delayline outdelay12;
-	delayline outdelay13;
-	delayline outdelay14;
+	//preset switch: the other path fades out with zero input and is retired early once it is quiet
+	std::atomic<bool> presetPending{ false };	//set by applyBankPreset( ) and shell preset loads, taken by the next buffer
+	bool parametersSynced = false;	//false until the first buffer has synced the parameters
+	bool stereoOut = false;	//host layout of the current buffer, the crossfade runs in processStereoFrame( ) only
+	bool stereoSource = false;
+	int fadeFrames = 0;	//length of the running fade, 0 = none
+	int fadePos = 0;
+	int tailHold = 0;	//frames the faded tail must stay quiet before it is retired
+	int tailQuiet = 0;
+	int clearStep = WetPath::objects;	//next object of the retired path to clear
+
+	ConvolutionReverb convolver;	//replaces diffuser and tank when engine is 1 and an impulse response is loaded
+	double impulseShape[16] = {};	//last value of each parameter that shapes the impulse response, by controlID
+	bool impulseStale = true;	//captured on the next buffer that runs with the convolution engine
+	int compensation = 0;	//latency of the configuration applied in reset(), the rest of the signal is delayed to match
+	bool restartPending = false;	//processing changed, it applies at the next reset()
+	delayline compensateL;
+	delayline compensateR;
+
+	double taps[TapMatrix::taps];	//output taps of the last frame
+	TapMatrix tapMatrix;			//wet outputs for more than two channels
+	DeadlineMonitor deadline;	//load of every buffer callback
+	LevelMeter meter;	//input, wet and tank levels of the stereo outputs, drained by the GUI timer
+	double tankmeter[2] = {};	//tank feedback of the last frame, 0 while the convolver runs
+	DecayAnalyzer analyzer;	//wet spectrum and RT60 on its own thread, for the DecayAnalyzerView
+	ICustomView* analyzerView = nullptr;	//GUI thread only
+	DecayEstimator decayEstimate;	//recomputed in preProcessAudioBuffers when a setting it depends on changes
+	std::atomic<float> estimatedRT60{ 0.f };	//broadband estimate for the GUI, negative = infinite
+	PresetBank presetBank;	//mapped by loadPresetBank, GUI thread only
+	ICustomView* bankView = nullptr;	//PresetBankView, GUI thread only
+	PresetBrowse bankBrowse;	//exchanged with bankView on the timer ping
+	CookedCoefficients cooked;	//audio thread: exp and pow of the current settings, recooked only when a value changes
+	moodycamel::ReaderWriterQueue<CookedCoefficients> morphQueue{ 32 };	//sets cooked by setMorph( ), taken in preProcessAudioBuffers( )
+	std::vector<MorphRange> morphRanges;	//GUI thread only
+	std::atomic<double> morphRate{ 0.0 };	//sample rate of the last reset( ), read by setMorph( ) on the GUI thread
+#ifdef DTREVERB_PROFILE
+	StageProfile profile;	//written by the audio thread only, see profileReport()
+#endif
 	// **--0x1A7F--**
     // --- end member variables
 
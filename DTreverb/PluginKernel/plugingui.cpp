@@ -3,6 +3,8 @@
 
 // --- custom data view example; include more custom views here
 #include "customviews.h"
+#include "analyzerview.h"
+#include "presetbankview.h"
 
 #if MAC
 #include <CoreFoundation/CoreFoundation.h>
@@ -1788,6 +1790,18 @@ CView* PluginGUI::createUserCustomView(std::string viewname, const CRect rect, I
 		return new WaveView(rect, listener, tag);
 	}
 
+	if (viewname.compare("DecayAnalyzerView") == 0)
+	{
+		// --- wet spectrum and RT60, fed by the core on the timer ping
+		return new DecayAnalyzerView(rect, listener, tag);
+	}
+
+	if (viewname.compare("PresetBankView") == 0)
+	{
+		// --- presets of the mapped binary bank, applied by the core on the timer ping
+		return new PresetBankView(rect, listener, tag);
+	}
+
 	if (viewname.compare("CustomSpectrumView") == 0)
 	{
 #ifdef HAVE_FFTW
@@ -474,13 +474,14 @@ struct GUIUpdateData
 Use this enum to identify a message to send to the plugin shell (host)
 
 - sendGUIUpdate or sendRAFXStatusWndText
+- sendLatencyUpdate: getLatencyInSamples( ) changed; no shell handles it yet, so it is currently dropped
 
 \author Will Pirkle http://www.willpirkle.com
 \remark This object is included in Designing Audio Effects Plugins in C++ 2nd Ed. by Will Pirkle
 \version Revision : 1.0
 \date Date : 2018 / 09 / 7
 */
-enum hostMessage { sendGUIUpdate, sendRAFXStatusWndText };
+enum hostMessage { sendGUIUpdate, sendRAFXStatusWndText, sendLatencyUpdate };
 
 struct HostMessageInfo
 {
@@ -687,7 +688,8 @@ enum messageType {
 	PLUGIN_QUERY_DESCRIPTION,				/* fill in a Rafx2PluginDescriptor for host */
 	PLUGIN_QUERY_PARAMETER,					/* fill in a Rafx2PluginParameter for host inMessageData = index of parameter*/
 	PLUGIN_QUERY_TRACKPAD_X,
-	PLUGIN_QUERY_TRACKPAD_Y
+	PLUGIN_QUERY_TRACKPAD_Y,
+	PLUGIN_QUERY_PROFILE					/* DTREVERB_PROFILE builds: per-stage cycle report in outMessageString, inMessageData non-null clears it */
 };
 
 
@@ -0,0 +1,70 @@
+#include "presetbankview.h"
+
+namespace VSTGUI {
+
+PresetBankView::PresetBankView(const CRect& size, IControlListener* listener, int32_t tag)
+: COptionMenu(size, nullptr, tag)
+{
+	rebuild();
+}
+
+void PresetBankView::rebuild()
+{
+	removeAllEntry();
+	addEntry("Load bank...");
+	if (names.empty()) return;
+
+	addSeparator();
+	for (size_t i = 0; i < names.size(); i++)
+		addEntry(names[i].c_str());
+}
+
+void PresetBankView::updateView()
+{
+	if (!fresh) return;
+	fresh = false;
+	rebuild();
+	setCurrent(loadEntry);
+	invalid();
+}
+
+void PresetBankView::sendMessage(void* data)
+{
+	if (!data) return;
+	PresetBrowse* browse = (PresetBrowse*)data;
+	if (browse->namesChanged)
+	{
+		names = browse->names;
+		browse->namesChanged = false;
+		fresh = true;
+	}
+
+	// --- hand back what was picked since the last ping
+	browse->selected = selected;
+	browse->loadPath = loadPath;
+	selected = -1;
+	loadPath.clear();
+}
+
+void PresetBankView::valueChanged()
+{
+	int32_t index = getCurrentIndex(true);	//separator counted, as in the enum
+	if (index >= firstPreset)
+	{
+		selected = index - firstPreset;
+		return;
+	}
+	if (index != loadEntry || !getFrame())
+		return;
+
+	CNewFileSelector* fileSelector = CNewFileSelector::create(getFrame(), CNewFileSelector::kSelectFile);
+	if (fileSelector == 0)
+		return;
+
+	fileSelector->setTitle("Load Preset Bank");
+	if (fileSelector->runModal() && fileSelector->getSelectedFile(0))
+		loadPath = fileSelector->getSelectedFile(0);
+	fileSelector->forget();
+}
+
+}
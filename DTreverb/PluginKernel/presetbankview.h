@@ -0,0 +1,59 @@
+// -----------------------------------------------------------------------------
+//    DTreverb custom view:  presetbankview.h
+//
+/**
+    \file   presetbankview.h
+    \brief  preset browser for the binary preset bank mapped by PluginCore
+*/
+// -----------------------------------------------------------------------------
+#pragma once
+#ifndef __presetbankview_h__
+#define __presetbankview_h__
+
+#include "vstgui/vstgui.h"
+#include "pluginstructures.h"
+#include "..\DTreverb\win_build\COMMON\PresetBank.h"
+
+namespace VSTGUI {
+
+/**
+\class PresetBankView
+\ingroup Custom-Views
+\brief
+Option menu listing the presets of the mapped bank, with a first entry that picks a bank file.
+
+Operation:
+- PluginCore registers it under the custom view name "PresetBankView"
+- on every GUI timer ping the core passes its PresetBrowse through sendMessage( ); the view takes the
+  new names and leaves the preset or bank file picked since the last ping, which the core then applies
+  with applyBankPreset( ) or loadPresetBank( ); everything runs on the GUI thread
+- a pick is not a parameter change, so the GUI's listener never sees it
+*/
+class PresetBankView : public COptionMenu, public ICustomView
+{
+public:
+	PresetBankView(const CRect& size, IControlListener* listener, int32_t tag);
+
+	/** ICustomView: rebuild the menu if new names arrived */
+	virtual void updateView() override;
+
+	/** ICustomView: data is a PresetBrowse* owned by the core */
+	virtual void sendMessage(void* data) override;
+
+	/** COptionMenu: a menu pick, kept for the next timer ping */
+	virtual void valueChanged() override;
+
+protected:
+	void rebuild();
+
+	enum { loadEntry, separatorEntry, firstPreset };	///< menu layout, presets follow the separator
+
+	std::vector<std::string> names;
+	bool fresh = false;
+	int32_t selected = -1;
+	std::string loadPath;
+};
+
+}
+
+#endif